@@ -32,30 +32,14 @@ const cmd = args[0].toString();
 const cmdPath = which(cmd) ?? cmd;
 const cmdArgs = args.slice(1).map(String);
 
-const lock = create({ write: dirs, network: argv.net as boolean });
+// the child writes straight to our stdio; no bytes pass through JS
+const lock = create({
+  write: dirs,
+  network: argv.net as boolean,
+  stdio: { stdin: "inherit", stdout: "inherit", stderr: "inherit" },
+});
 lock.spawn(cmdPath, cmdArgs);
 
-// stream stdout/stderr to parent
-const stdout = Bun.file(lock.stdoutFd()).stream();
-const stderr = Bun.file(lock.stderrFd()).stream();
-
-async function pipe(stream: ReadableStream<Uint8Array>, out: typeof Bun.stdout) {
-  const reader = stream.getReader();
-  try {
-    while (true) {
-      const { done, value } = await reader.read();
-      if (done) break;
-      out.write(value);
-    }
-  } catch {
-    /* fd closed */
-  }
-}
-
-const p1 = pipe(stdout, Bun.stdout);
-const p2 = pipe(stderr, Bun.stderr);
-
-const code = lock.wait();
-await Promise.allSettled([p1, p2]);
+const code = await lock.exited;
 lock.destroy();
 process.exit(code);
@@ -1,5 +1,5 @@
 import { createRequire } from "module";
-import { Readable } from "stream";
+import { Readable, Writable } from "stream";
 import { constants } from "os";
 import fs from "fs";
 import path from "path";
@@ -23,6 +23,94 @@ const prebuilt =
 
 const native = prebuilt && fs.existsSync(prebuilt) ? require(prebuilt) : require(local);
 
+export interface Capabilities {
+  /** the platform sandbox can be applied at all */
+  available: boolean;
+  /** Landlock ABI version (-1 when not on Linux or unsupported) */
+  abi: number;
+  /** Landlock filesystem access rights that will be enforced */
+  fs: number;
+  /** Landlock network access rights that will be enforced */
+  net: number;
+  /** kernel supports Landlock scoping (ABI 6) */
+  scoped: boolean;
+  /** kernel supports LANDLOCK_ACCESS_FS_IOCTL_DEV (ABI 5) */
+  ioctlDev: boolean;
+  /** kernel supports Landlock audit logging (ABI 7) */
+  audit: boolean;
+  /** loops can run on io_uring (multishot reads, not blocked by seccomp) */
+  ioUring: boolean;
+}
+
+/** what the running kernel can enforce; probed once when the addon loads */
+export function capabilities(): Capabilities {
+  return native.capabilities();
+}
+
+export interface RuntimeOpts {
+  /**
+   * spawn through a zygote forked now (Linux only): a copy of this process as
+   * it is at the time of the call, so call init() before the heap grows
+   */
+  zygote?: boolean;
+}
+
+/** process-wide setup; optional, and safe to call more than once */
+export function init(opts: RuntimeOpts = {}): void {
+  native.runtimeInit(opts);
+}
+
+/** stops the zygote, if any; children it already spawned keep running */
+export function shutdown(): void {
+  native.runtimeShutdown();
+}
+
+/** nanoseconds; create-time phases plus the most recent spawn */
+export interface Stats {
+  /** sb_create: opening and validating scope directories */
+  scopeNs: number;
+  /** sb_create: compiling the ruleset or profile */
+  rulesetNs: number;
+  /** creating the stdio pipes */
+  pipesNs: number;
+  /** clone/fork until the child starts running */
+  forkNs: number;
+  /** child: signal reset and stdio wiring */
+  setupNs: number;
+  /** child: applying the sandbox */
+  restrictNs: number;
+  /** child calling execve until the parent sees it succeed */
+  execNs: number;
+  /** whole spawn, parent side */
+  spawnNs: number;
+  /** children started from this sandbox */
+  numSpawns: number;
+}
+
+/**
+ * "pipe" gives the parent an fd (and stream) for it; "inherit" shares the
+ * parent's; "null" is /dev/null; a number is an fd of yours the child gets a
+ * copy of. Only stderr may be "merge", which sends it wherever stdout goes.
+ * "memfd" (stdout/stderr) collects the output in memory for stdoutBuffer()
+ * and stderrBuffer() after exit.
+ */
+export type StdioMode = "pipe" | "inherit" | "null" | number;
+
+export interface StdioOpts {
+  stdin?: StdioMode;
+  stdout?: StdioMode | "memfd";
+  stderr?: StdioMode | "merge" | "memfd";
+}
+
+export interface RunResult {
+  /** exit code */
+  code: number;
+  /** everything written to stdout, mapped rather than copied */
+  stdoutBuffer: ArrayBuffer;
+  /** everything written to stderr, mapped rather than copied */
+  stderrBuffer: ArrayBuffer;
+}
+
 export interface SandboxOpts {
   /** directories readable by the sandboxed process */
   read?: string[];
@@ -30,17 +118,121 @@ export interface SandboxOpts {
   write?: string[];
   /** allow network access (default: false) */
   network?: boolean;
+  /** default stdio for every spawn (default: all pipes) */
+  stdio?: StdioOpts;
+  /** capacity of each stdio pipe in bytes, Linux only (default: kernel default, 64 KiB) */
+  pipeSize?: number;
+  /** make the parent's pipe ends O_NONBLOCK (default: false) */
+  nonblock?: boolean;
+  /** descriptors passed to every child under the same numbers; all others above stderr are closed (default: none) */
+  inheritFds?: number[];
 }
 
 const sandboxDefaults: Required<SandboxOpts> = {
   read: [],
   write: [],
   network: false,
+  stdio: {},
+  pipeSize: 0,
+  nonblock: false,
+  inheritFds: [],
 };
 
+export interface SpawnSpec {
+  cmd: string;
+  args?: string[];
+  /** overrides the sandbox's stdio for this child */
+  stdio?: StdioOpts;
+}
+
+export type StreamName = "stdout" | "stderr";
+
+export interface ForwardOpts {
+  /** also keep everything forwarded in memory (default: false) */
+  tee?: boolean;
+}
+
+export interface Forwarded {
+  /** bytes written to the destination */
+  bytes: number;
+  /** what went through, with tee; otherwise null */
+  copy: Buffer | null;
+}
+
+export interface CaptureOpts {
+  /** bytes kept from the start of the stream */
+  head?: number;
+  /** bytes kept from the end of the stream */
+  tail?: number;
+  /** SIGKILL the child once the stream passes this many bytes (default: no limit) */
+  quota?: number;
+}
+
+export interface Captured {
+  head: Buffer;
+  tail: Buffer;
+  /** everything the child wrote, kept or not */
+  total: number;
+  /** the child was killed for exceeding the quota */
+  overQuota: boolean;
+}
+
+export interface Child {
+  /** child pid */
+  pid(): number;
+  /** fd you write to for child stdin */
+  stdinFd(): number;
+  /** fd you read from for child stdout */
+  stdoutFd(): number;
+  /** fd you read from for child stderr */
+  stderrFd(): number;
+  /** writable stream into child stdin; don't modify a Buffer after writing it */
+  stdin(): Writable;
+  /** readable stream of child stdout */
+  stdout(): Readable;
+  /** readable stream of child stderr */
+  stderr(): Readable;
+  /** move a stream to `fd` natively (splice on Linux) until EOF; it no longer reaches stdout()/stderr() */
+  forward(stream: StreamName, fd: number, opts?: ForwardOpts): void;
+  /** blocks until the forwarded stream hits EOF, so call it once the child has exited */
+  forwardWait(stream: StreamName): Forwarded;
+  /** drain a stream natively, keeping at most head + tail bytes of it */
+  capture(stream: StreamName, opts: CaptureOpts): void;
+  /** blocks until the captured stream hits EOF, so call it once the child has exited */
+  captureWait(stream: StreamName): Captured;
+  /** the "memfd" stdout of an exited child, without a copy */
+  stdoutBuffer(): ArrayBuffer;
+  /** the "memfd" stderr of an exited child, without a copy */
+  stderrBuffer(): ArrayBuffer;
+  /** pidfd that becomes readable when the child exits (-1 where unsupported) */
+  pidfd(): number;
+  /** blocking wait for exit. returns exit code. */
+  wait(): number;
+  /** resolves with the exit code; never blocks the event loop */
+  waitAsync(): Promise<number>;
+  /** the same promise on every access */
+  readonly exited: Promise<number>;
+  /** exit code if the child has exited, otherwise null. never blocks. */
+  tryWait(): number | null;
+  /** wait at most `ms` for exit. returns exit code, or null on timeout. */
+  waitTimeout(ms: number): number | null;
+  /** send a signal to the child */
+  kill(signal?: number): void;
+  /** kill if running, close its fds */
+  destroy(): void;
+}
+
 export interface Sandbox {
   /** spawn a process inside the sandbox */
   spawn(cmd: string, args?: string[]): void;
+  /** spawn another process under the same policy, with its own handle */
+  spawnChild(cmd: string, args?: string[], stdio?: StdioOpts): Child;
+  /** spawn several processes under the same policy in one batch; all start or none do */
+  spawnMany(specs: SpawnSpec[]): Child[];
+  /** run to completion with stdout and stderr in memfds; never blocks the event loop */
+  run(cmd: string, args?: string[]): Promise<RunResult>;
+  /** start a process that has already applied this policy and forks children for it, Linux only */
+  server(): ForkServer;
   /** child pid (-1 if not spawned) */
   pid(): number;
   /** fd you write to for child stdin */
@@ -49,18 +241,232 @@ export interface Sandbox {
   stdoutFd(): number;
   /** fd you read from for child stderr */
   stderrFd(): number;
+  /** writable stream into child stdin; don't modify a Buffer after writing it */
+  stdin(): Writable;
   /** readable stream of child stdout */
   stdout(): Readable;
   /** readable stream of child stderr */
   stderr(): Readable;
+  /** move a stream to `fd` natively (splice on Linux) until EOF; it no longer reaches stdout()/stderr() */
+  forward(stream: StreamName, fd: number, opts?: ForwardOpts): void;
+  /** blocks until the forwarded stream hits EOF, so call it once the child has exited */
+  forwardWait(stream: StreamName): Forwarded;
+  /** drain a stream natively, keeping at most head + tail bytes of it */
+  capture(stream: StreamName, opts: CaptureOpts): void;
+  /** blocks until the captured stream hits EOF, so call it once the child has exited */
+  captureWait(stream: StreamName): Captured;
+  /** the "memfd" stdout of an exited child, without a copy */
+  stdoutBuffer(): ArrayBuffer;
+  /** the "memfd" stderr of an exited child, without a copy */
+  stderrBuffer(): ArrayBuffer;
+  /** pidfd that becomes readable when the child exits (-1 where unsupported) */
+  pidfd(): number;
   /** blocking wait for exit. returns exit code. */
   wait(): number;
+  /** resolves with the exit code; never blocks the event loop */
+  waitAsync(): Promise<number>;
+  /** the same promise on every access */
+  readonly exited: Promise<number>;
+  /** exit code if the child has exited, otherwise null. never blocks. */
+  tryWait(): number | null;
+  /** wait at most `ms` for exit. returns exit code, or null on timeout. */
+  waitTimeout(ms: number): number | null;
   /** send a signal to the child */
   kill(signal?: number): void;
+  /** per-phase timing for creation and the most recent spawn */
+  stats(): Stats;
   /** kill if running, free all resources */
   destroy(): void;
 }
 
+const STDOUT = 1;
+const STDERR = 2;
+const EXIT = 3;
+
+/** native handle behind every Sandbox and Child, for APIs that take either */
+const handles = new WeakMap<Sandbox | Child, unknown>();
+
+const streamIds: Record<StreamName, number> = { stdout: STDOUT, stderr: STDERR };
+
+/** bytes requested from the pipe per read */
+const READ_CHUNK = 64 * 1024;
+/** reads are carved out of slabs this size, the way fs streams pool */
+const POOL_SIZE = 1024 * 1024;
+
+let slab = Buffer.allocUnsafe(POOL_SIZE);
+let poolOffset = 0;
+
+function poolTake(): Buffer {
+  if (POOL_SIZE - poolOffset < READ_CHUNK) {
+    slab = Buffer.allocUnsafe(POOL_SIZE);
+    poolOffset = 0;
+  }
+  const buf = slab.subarray(poolOffset, poolOffset + READ_CHUNK);
+  poolOffset += READ_CHUNK;
+  return buf;
+}
+
+function poolGiveBack(buf: Buffer, used: number) {
+  // only the most recent window can shrink; others keep their whole chunk
+  if (buf.buffer !== slab.buffer || buf.byteOffset + READ_CHUNK - slab.byteOffset !== poolOffset) return;
+  poolOffset -= READ_CHUNK - ((used + 7) & ~7);
+}
+
+/** bytes buffered by stdin() before write() starts returning false */
+const STDIN_HIGH_WATER = 1024 * 1024;
+
+/** chunks longer than this are spliced into the pipe (SL_FORWARD_CHUNK natively) */
+const STDIN_GIFT_MIN = 64 * 1024;
+
+/**
+ * Writable over the child's stdin pipe. Writes happen natively and never
+ * block the event loop, and a write completes once the whole chunk is in
+ * the pipe, so a child that stops reading holds the producer back. On
+ * Linux a large chunk's pages are spliced into the pipe rather than copied;
+ * such a chunk stays referenced until the child has read past it (or
+ * exited), which is why it must not be modified after writing.
+ */
+function stdinStream(handle: unknown, exited: () => Promise<number>): Writable {
+  const held: { chunk: Buffer; end: number }[] = [];
+  let written = 0;
+
+  const release = () => {
+    const consumed = written - native.stdinUnread(handle);
+    while (held.length && held[0].end <= consumed) held.shift();
+  };
+  const releaseAll = () => {
+    held.length = 0;
+  };
+
+  return new Writable({
+    highWaterMark: STDIN_HIGH_WATER,
+    write(chunk: Buffer, _encoding, callback) {
+      native.writeAsync(handle, chunk).then(
+        (n: number) => {
+          written += n;
+          if (chunk.length > STDIN_GIFT_MIN) held.push({ chunk, end: written });
+          release();
+          callback();
+        },
+        (err: Error) => callback(err),
+      );
+    },
+    final(callback) {
+      try {
+        native.closeStdin(handle);
+      } catch (err) {
+        callback(err as Error);
+        return;
+      }
+      exited().then(releaseAll, releaseAll);
+      callback();
+    },
+    destroy(err, callback) {
+      try {
+        if (native.stdinFd(handle) >= 0) native.closeStdin(handle);
+      } catch {
+        // already closed; the stream is going away either way
+      }
+      exited().then(releaseAll, releaseAll);
+      callback(err);
+    },
+  });
+}
+
+/**
+ * Readable over a child pipe. Reads happen natively and never block the
+ * event loop; _read is only called again once the consumer wants more, so
+ * a slow consumer leaves data in the pipe and the child blocks on write.
+ */
+function stream(handle: unknown, which: number): Readable {
+  return new Readable({
+    highWaterMark: READ_CHUNK,
+    read() {
+      const buf = poolTake();
+      native.readAsync(handle, which, buf).then(
+        (n: number) => {
+          poolGiveBack(buf, n);
+          this.push(n === 0 ? null : buf.subarray(0, n));
+        },
+        (err: Error) => {
+          poolGiveBack(buf, 0);
+          this.destroy(err);
+        },
+      );
+    },
+  });
+}
+
+function child(handle: unknown): Child {
+  let destroyed = false;
+  let exited: Promise<number> | undefined;
+  let stdin: Writable | undefined;
+  let stdout: Readable | undefined;
+  let stderr: Readable | undefined;
+
+  const api: Child = {
+    pid: () => native.pid(handle),
+    stdinFd: () => native.stdinFd(handle),
+    stdoutFd: () => native.stdoutFd(handle),
+    stderrFd: () => native.stderrFd(handle),
+    stdin: () => (stdin ??= stdinStream(handle, () => api.exited)),
+    stdout: () => (stdout ??= stream(handle, STDOUT)),
+    stderr: () => (stderr ??= stream(handle, STDERR)),
+    forward: (which: StreamName, fd: number, opts: ForwardOpts = {}) =>
+      native.forward(handle, streamIds[which], fd, opts.tee ?? false),
+    forwardWait: (which: StreamName) => native.forwardWait(handle, streamIds[which]),
+    capture: (which: StreamName, opts: CaptureOpts) => native.capture(handle, streamIds[which], opts),
+    captureWait: (which: StreamName) => native.captureWait(handle, streamIds[which]),
+    stdoutBuffer: () => native.outputBuffer(handle, STDOUT),
+    stderrBuffer: () => native.outputBuffer(handle, STDERR),
+    pidfd: () => native.pidfd(handle),
+    wait: () => native.wait(handle),
+    waitAsync: () => native.waitAsync(handle),
+    get exited() {
+      return (exited ??= native.waitAsync(handle));
+    },
+    tryWait: () => native.tryWait(handle),
+    waitTimeout: (ms: number) => native.waitTimeout(handle, ms),
+
+    kill(signal: number = constants.signals.SIGTERM) {
+      native.kill(handle, signal);
+    },
+
+    destroy() {
+      if (destroyed) return;
+      destroyed = true;
+      native.destroy(handle);
+    },
+  };
+  handles.set(api, handle);
+  return api;
+}
+
+export interface ForkServer {
+  /** fork+exec a child that is born inside the sandbox; only the exec is paid per task */
+  spawn(cmd: string, args?: string[]): Child;
+  /** stop the server; children it spawned keep running */
+  destroy(): void;
+}
+
+/** the server borrows the sandbox's context, so every spawn names both */
+function forkServer(owner: unknown): ForkServer {
+  const handle = native.serverCreate(owner);
+  let destroyed = false;
+
+  return {
+    spawn(cmd: string, args: string[] = []): Child {
+      return child(native.serverSpawn(owner, handle, cmd, args));
+    },
+
+    destroy() {
+      if (destroyed) return;
+      destroyed = true;
+      native.destroy(handle);
+    },
+  };
+}
+
 export function create(opts: SandboxOpts = {}): Sandbox {
   const cfg: Required<SandboxOpts> = {
     ...sandboxDefaults,
@@ -70,12 +476,48 @@ export function create(opts: SandboxOpts = {}): Sandbox {
   const handle = native.create(cfg);
 
   let destroyed = false;
+  let exited: Promise<number> | undefined;
+  let stdin: Writable | undefined;
+  let stdout: Readable | undefined;
+  let stderr: Readable | undefined;
 
-  return {
+  const api: Sandbox = {
     spawn(cmd: string, args: string[] = []) {
       native.spawn(handle, cmd, args);
     },
 
+    spawnChild(cmd: string, args: string[] = [], stdio?: StdioOpts): Child {
+      if (stdio) return child(native.spawnMany(handle, [{ cmd, args, stdio }])[0]);
+      return child(native.spawnChild(handle, cmd, args));
+    },
+
+    spawnMany(specs: SpawnSpec[]): Child[] {
+      const handles: unknown[] = native.spawnMany(
+        handle,
+        specs.map((spec) => ({ cmd: spec.cmd, args: spec.args ?? [], ...(spec.stdio && { stdio: spec.stdio }) })),
+      );
+      return handles.map(child);
+    },
+
+    async run(cmd: string, args: string[] = []): Promise<RunResult> {
+      const stdio: StdioOpts = { stdin: "null", stdout: "memfd", stderr: "memfd" };
+      const [ran] = native.spawnMany(handle, [{ cmd, args, stdio }]);
+      try {
+        const code: number = await native.waitAsync(ran);
+        return {
+          code,
+          stdoutBuffer: native.outputBuffer(ran, STDOUT),
+          stderrBuffer: native.outputBuffer(ran, STDERR),
+        };
+      } finally {
+        native.destroy(ran);
+      }
+    },
+
+    server(): ForkServer {
+      return forkServer(handle);
+    },
+
     pid(): number {
       return native.pid(handle);
     },
@@ -92,73 +534,403 @@ export function create(opts: SandboxOpts = {}): Sandbox {
       return native.stderrFd(handle);
     },
 
-    stdout(): Readable { return new Readable(); },
-    stderr(): Readable { return new Readable(); },
-
-    // stdout(): Readable {
-    //   const fd = native.stdoutFd(handle);
-    //   if (fd < 0) throw new Error("not spawned");
-    //   return Readable.fromWeb(
-    //     new ReadableStream({
-    //       start(controller) {
-    //         const file = Bun.file(fd);
-    //         const reader = file.stream().getReader();
-    //         (async () => {
-    //           try {
-    //             while (true) {
-    //               const { done, value } = await reader.read();
-    //               if (done) break;
-    //               controller.enqueue(value);
-    //             }
-    //           } catch {
-    //             /* fd closed */
-    //           } finally {
-    //             controller.close();
-    //           }
-    //         })();
-    //       },
-    //     })
-    //   );
-    // },
-
-    // stderr(): Readable {
-    //   const fd = native.stderrFd(handle);
-    //   if (fd < 0) throw new Error("not spawned");
-    //   return Readable.fromWeb(
-    //     new ReadableStream({
-    //       start(controller) {
-    //         const file = Bun.file(fd);
-    //         const reader = file.stream().getReader();
-    //         (async () => {
-    //           try {
-    //             while (true) {
-    //               const { done, value } = await reader.read();
-    //               if (done) break;
-    //               controller.enqueue(value);
-    //             }
-    //           } catch {
-    //             /* fd closed */
-    //           } finally {
-    //             controller.close();
-    //           }
-    //         })();
-    //       },
-    //     })
-    //   );
-    // },
+    stdin(): Writable {
+      return (stdin ??= stdinStream(handle, () => api.exited));
+    },
+
+    stdout(): Readable {
+      return (stdout ??= stream(handle, STDOUT));
+    },
+
+    stderr(): Readable {
+      return (stderr ??= stream(handle, STDERR));
+    },
+
+    forward(which: StreamName, fd: number, opts: ForwardOpts = {}) {
+      native.forward(handle, streamIds[which], fd, opts.tee ?? false);
+    },
+
+    forwardWait(which: StreamName): Forwarded {
+      return native.forwardWait(handle, streamIds[which]);
+    },
+
+    capture(which: StreamName, opts: CaptureOpts) {
+      native.capture(handle, streamIds[which], opts);
+    },
+
+    captureWait(which: StreamName): Captured {
+      return native.captureWait(handle, streamIds[which]);
+    },
+
+    stdoutBuffer(): ArrayBuffer {
+      return native.outputBuffer(handle, STDOUT);
+    },
+
+    stderrBuffer(): ArrayBuffer {
+      return native.outputBuffer(handle, STDERR);
+    },
+
+    pidfd(): number {
+      return native.pidfd(handle);
+    },
 
     wait(): number {
       return native.wait(handle);
     },
 
+    waitAsync(): Promise<number> {
+      return native.waitAsync(handle);
+    },
+
+    get exited(): Promise<number> {
+      return (exited ??= native.waitAsync(handle));
+    },
+
+    tryWait(): number | null {
+      return native.tryWait(handle);
+    },
+
+    waitTimeout(ms: number): number | null {
+      return native.waitTimeout(handle, ms);
+    },
+
     kill(signal: number = constants.signals.SIGTERM) {
       native.kill(handle, signal);
     },
 
+    stats(): Stats {
+      return native.stats(handle);
+    },
+
     destroy() {
       if (destroyed) return;
       destroyed = true;
       native.destroy(handle);
     },
   };
+  handles.set(api, handle);
+  return api;
+}
+
+export interface LoopEvent {
+  target: Sandbox | Child;
+  kind: StreamName | "exit";
+  /** output; null at EOF and for exits */
+  data: Buffer | null;
+  /** exit code, for exits */
+  code: number | null;
+}
+
+export type LoopBackend = "poll" | "io_uring";
+
+export interface LoopOpts {
+  /** default: io_uring when capabilities().ioUring, else epoll/kqueue */
+  backend?: LoopBackend | "auto";
+}
+
+export interface Loop {
+  /** which kernel interface is doing the work */
+  readonly backend: LoopBackend;
+  /** watch a spawned child's output pipes and exit */
+  add(target: Sandbox | Child): void;
+  /** stop watching; destroying the target does this too */
+  remove(target: Sandbox | Child): void;
+  /** resolves with the next batch of events; never blocks the event loop */
+  next(): Promise<LoopEvent[]>;
+  /** stop watching everything */
+  destroy(): void;
+}
+
+/**
+ * One native epoll/kqueue set (or io_uring) over any number of children,
+ * drained in batches: a tick costs O(ready) rather than a stream and a
+ * waiter per child. A target leaves the loop by itself after its exit and
+ * both EOFs.
+ */
+export function loop(opts: LoopOpts = {}): Loop {
+  const handle = native.loopCreate(opts.backend ?? "auto");
+  const targets = new Map<number, Sandbox | Child>();
+  const kinds: Record<number, LoopEvent["kind"]> = { [STDOUT]: "stdout", [STDERR]: "stderr", [EXIT]: "exit" };
+  let nextId = 0;
+  let destroyed = false;
+
+  return {
+    backend: native.loopBackend(handle),
+
+    add(target: Sandbox | Child) {
+      const id = nextId++ >>> 0;
+      native.loopAdd(handle, handles.get(target), id);
+      targets.set(id, target);
+    },
+
+    remove(target: Sandbox | Child) {
+      native.loopRemove(handle, handles.get(target));
+      for (const [id, t] of targets) {
+        if (t === target) targets.delete(id);
+      }
+    },
+
+    async next(): Promise<LoopEvent[]> {
+      for (;;) {
+        const batch: { kind: number; id: number; data: Buffer | null; code: number | null; last: boolean }[] =
+          native.loopPoll(handle);
+        if (batch.length) {
+          return batch.map((event) => {
+            const target = targets.get(event.id)!;
+            if (event.last) targets.delete(event.id);
+            return { target, kind: kinds[event.kind], data: event.data, code: event.code };
+          });
+        }
+        await native.loopWait(handle);
+      }
+    },
+
+    destroy() {
+      if (destroyed) return;
+      destroyed = true;
+      targets.clear();
+      native.destroy(handle);
+    },
+  };
+}
+
+export interface PoolOpts {
+  /** interpreter each worker runs, Bun or Node (default: the one running this process) */
+  runtime?: string;
+  /** workers kept warm (default: 4) */
+  size?: number;
+  /** tasks a worker runs before it is replaced (default: 100) */
+  maxTasks?: number;
+  /** policy the workers run under; stdio belongs to the pool */
+  sandbox?: SandboxOpts;
+}
+
+export interface Pool {
+  /** import `script` in a warm worker and call its default export with `args`; resolves with what it returns, as JSON */
+  run<T = unknown>(script: string, ...args: unknown[]): Promise<T>;
+  /** move to a new policy; idle workers are replaced now, busy ones after their current task */
+  policy(opts: SandboxOpts): void;
+  /** workers alive, busy or not */
+  size(): number;
+  /** kill every worker and reject whatever hasn't finished */
+  destroy(): void;
+}
+
+/** workers talk on stdin/stdout; their stderr, and anything a script logs, goes to ours */
+const POOL_STDIO: StdioOpts = { stdin: "pipe", stdout: "pipe", stderr: "inherit" };
+
+/**
+ * Runs inside each worker (as `-e`, so CommonJS on both runtimes). Frames
+ * are a u32 little-endian length and that much JSON, one reply per task, in
+ * order. stdout is the protocol, so console output is moved to stderr, and
+ * process.stdout is never created: Node's getter makes fd 1 O_NONBLOCK, and
+ * the blocking frame writes would then fail on a full pipe. EOF on stdin
+ * means the host is done with this worker.
+ */
+const POOL_WORKER = `
+const fs = require("fs");
+const { pathToFileURL } = require("url");
+Object.defineProperty(process, "stdout", { configurable: true, enumerable: true, get: () => process.stderr });
+console.log = console.info = console.debug = console.error;
+
+const send = (reply) => {
+  const body = Buffer.from(JSON.stringify(reply));
+  const frame = Buffer.allocUnsafe(4 + body.length);
+  frame.writeUInt32LE(body.length, 0);
+  body.copy(frame, 4);
+  for (let off = 0; off < frame.length; ) off += fs.writeSync(1, frame, off);
+};
+
+const run = async ({ script, args }) => {
+  try {
+    const mod = await import(pathToFileURL(script).href);
+    if (typeof mod.default !== "function") throw new Error(script + " has no default export to call");
+    send({ result: await mod.default(...args) });
+  } catch (err) {
+    send({ error: String((err && err.stack) || err) });
+  }
+};
+
+let pending = Buffer.alloc(0);
+let chain = Promise.resolve();
+process.stdin.on("data", (chunk) => {
+  pending = Buffer.concat([pending, chunk]);
+  while (pending.length >= 4 && pending.length >= 4 + pending.readUInt32LE(0)) {
+    const len = pending.readUInt32LE(0);
+    const task = JSON.parse(pending.toString("utf8", 4, 4 + len));
+    pending = pending.subarray(4 + len);
+    chain = chain.then(() => run(task));
+  }
+});
+process.stdin.on("end", () => chain.then(() => process.exit(0)));
+`;
+
+interface PoolTask {
+  script: string;
+  args: unknown[];
+  resolve(value: unknown): void;
+  reject(err: Error): void;
+}
+
+interface PoolWorker {
+  child: Child;
+  stdin: Writable;
+  task: PoolTask | null;
+  tasks: number;
+  stale: boolean;
+}
+
+function frame(value: unknown): Buffer {
+  const body = Buffer.from(JSON.stringify(value));
+  const out = Buffer.allocUnsafe(4 + body.length);
+  out.writeUInt32LE(body.length, 0);
+  body.copy(out, 4);
+  return out;
+}
+
+/**
+ * Keeps `size` sandboxed interpreters running so a task pays a pipe round
+ * trip instead of runtime startup. A worker runs one task at a time and is
+ * replaced after `maxTasks`, so state a script leaves behind doesn't live
+ * forever. One that dies mid-task rejects that task and is replaced on
+ * demand rather than eagerly, so a runtime that can't start doesn't spin.
+ */
+export function pool(opts: PoolOpts = {}): Pool {
+  const runtime = opts.runtime ?? process.execPath;
+  const size = Math.max(1, opts.size ?? 4);
+  const maxTasks = Math.max(1, opts.maxTasks ?? 100);
+  const workers = new Set<PoolWorker>();
+  const queue: PoolTask[] = [];
+  let sandbox = create({ ...opts.sandbox, stdio: POOL_STDIO });
+  let destroyed = false;
+
+  const spawn = (): PoolWorker => {
+    const child = sandbox.spawnChild(runtime, ["-e", POOL_WORKER]);
+    const worker: PoolWorker = { child, stdin: child.stdin(), task: null, tasks: 0, stale: false };
+    workers.add(worker);
+
+    let pending = Buffer.alloc(0);
+    child.stdout().on("data", (chunk: Buffer) => {
+      pending = pending.length ? Buffer.concat([pending, chunk]) : chunk;
+      while (pending.length >= 4 && pending.length >= 4 + pending.readUInt32LE(0)) {
+        const len = pending.readUInt32LE(0);
+        const reply = JSON.parse(pending.toString("utf8", 4, 4 + len));
+        pending = pending.subarray(4 + len);
+        finish(worker, reply);
+      }
+    });
+    worker.stdin.on("error", () => {
+      // the worker is gone; its exit settles the task
+    });
+
+    const exit = (code: unknown) => {
+      workers.delete(worker);
+      worker.task?.reject(new Error(`pool worker exited (${code}) before finishing`));
+      worker.task = null;
+      child.destroy();
+      dispatch();
+    };
+    child.exited.then(exit, exit);
+    return worker;
+  };
+
+  const retire = (worker: PoolWorker) => {
+    workers.delete(worker);
+    worker.stdin.end();
+  };
+
+  const fill = () => {
+    while (!destroyed && workers.size < size) spawn();
+  };
+
+  const finish = (worker: PoolWorker, reply: { result?: unknown; error?: string }) => {
+    const task = worker.task;
+    worker.task = null;
+    worker.tasks++;
+    if (reply.error !== undefined) task?.reject(new Error(reply.error));
+    if (reply.error === undefined) task?.resolve(reply.result);
+
+    if (worker.stale || worker.tasks >= maxTasks) {
+      retire(worker);
+      try {
+        fill();
+      } catch {
+        // dispatch() spawns on demand and reports the error to the tasks waiting
+      }
+    }
+    dispatch();
+  };
+
+  const dispatch = () => {
+    while (!destroyed && queue.length) {
+      let idle: PoolWorker | undefined;
+      for (const worker of workers) {
+        if (!worker.task) {
+          idle = worker;
+          break;
+        }
+      }
+
+      if (!idle && workers.size < size) {
+        try {
+          idle = spawn();
+        } catch (err) {
+          for (const task of queue.splice(0)) task.reject(err as Error);
+          return;
+        }
+      }
+      if (!idle) return;
+
+      const task = queue.shift()!;
+      idle.task = task;
+      idle.stdin.write(frame({ script: task.script, args: task.args }));
+    }
+  };
+
+  try {
+    fill();
+  } catch (err) {
+    for (const worker of workers) worker.child.kill(constants.signals.SIGKILL);
+    sandbox.destroy();
+    throw err;
+  }
+
+  return {
+    run<T = unknown>(script: string, ...args: unknown[]): Promise<T> {
+      if (destroyed) return Promise.reject(new Error("pool destroyed"));
+      return new Promise<T>((resolve, reject) => {
+        queue.push({ script: path.resolve(script), args, resolve: resolve as (value: unknown) => void, reject });
+        dispatch();
+      });
+    },
+
+    policy(next: SandboxOpts) {
+      if (destroyed) throw new Error("pool destroyed");
+      const previous = sandbox;
+      sandbox = create({ ...next, stdio: POOL_STDIO });
+      // children don't borrow the context, so workers under the old policy carry on without it
+      previous.destroy();
+
+      for (const worker of [...workers]) {
+        if (worker.task) worker.stale = true;
+        if (!worker.task) retire(worker);
+      }
+      fill();
+      dispatch();
+    },
+
+    size: () => workers.size,
+
+    destroy() {
+      if (destroyed) return;
+      destroyed = true;
+      for (const task of queue.splice(0)) task.reject(new Error("pool destroyed"));
+      for (const worker of workers) {
+        worker.task?.reject(new Error("pool destroyed"));
+        worker.task = null;
+        worker.child.kill(constants.signals.SIGKILL);
+      }
+      sandbox.destroy();
+    },
+  };
 }
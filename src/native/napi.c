@@ -5,6 +5,9 @@
 #define STEVELOCK_IMPLEMENTATION
 #include "stevelock.h"
 
+#include <fcntl.h>
+#include <sys/ioctl.h>
+
 typedef enum {
   SL_NAPI_OK = 0,
   SL_NAPI_ERROR = 1,
@@ -12,10 +15,71 @@ typedef enum {
   SL_NAPI_FAILED_ALLOC = 3,
 } sl_napi_err_t;
 
+typedef enum {
+  N_HANDLE_SANDBOX = 0,
+  N_HANDLE_CHILD = 1,
+  N_HANDLE_LOOP = 2,
+  N_HANDLE_SERVER = 3,
+} n_handle_kind_t;
+
 typedef struct {
+  n_handle_kind_t kind;
   sl_ctx_t* sb;
 } n_sb_handle_t;
 
+typedef struct {
+  n_handle_kind_t kind;
+  sl_child_t* child;
+} n_child_handle_t;
+
+typedef struct {
+  n_handle_kind_t kind;
+  sl_loop_t* loop;
+} n_loop_handle_t;
+
+/* `owner` is the sandbox handle whose context the server borrows. */
+typedef struct {
+  n_handle_kind_t kind;
+  sl_server_t* server;
+  n_sb_handle_t* owner;
+} n_server_handle_t;
+
+static void n_release(void* ptr) {
+  n_handle_kind_t kind = *(n_handle_kind_t*)ptr;
+
+  if (kind == N_HANDLE_SANDBOX) {
+    n_sb_handle_t* h = (n_sb_handle_t*)ptr;
+    if (h->sb) {
+      sb_destroy(h->sb);
+      h->sb = NULL;
+    }
+  }
+
+  if (kind == N_HANDLE_CHILD) {
+    n_child_handle_t* h = (n_child_handle_t*)ptr;
+    if (h->child) {
+      sb_child_destroy(h->child);
+      h->child = NULL;
+    }
+  }
+
+  if (kind == N_HANDLE_LOOP) {
+    n_loop_handle_t* h = (n_loop_handle_t*)ptr;
+    if (h->loop) {
+      sb_loop_destroy(h->loop);
+      h->loop = NULL;
+    }
+  }
+
+  if (kind == N_HANDLE_SERVER) {
+    n_server_handle_t* h = (n_server_handle_t*)ptr;
+    if (h->server) {
+      sb_server_destroy(h->server);
+      h->server = NULL;
+    }
+  }
+}
+
 void n_finalize(napi_env env, void* ptr, void* hint) {
   (void)env;
   (void)hint;
@@ -24,13 +88,8 @@ void n_finalize(napi_env env, void* ptr, void* hint) {
     return;
   }
 
-  n_sb_handle_t* h = (n_sb_handle_t*)ptr;
-  if (h->sb) {
-    sb_destroy(h->sb);
-    h->sb = NULL;
-  }
-
-  sl_free(h);
+  n_release(ptr);
+  sl_free(ptr);
 }
 
 #define NAPI_CALL(call)  \
@@ -45,13 +104,30 @@ void n_finalize(napi_env env, void* ptr, void* hint) {
 static n_sb_handle_t* n_get_handle(napi_env env, napi_value v) {
   n_sb_handle_t* h = NULL;
   NAPI_CALL(napi_get_value_external(env, v, (void**)&h));
-  if (!h || !h->sb) {
+  if (!h || h->kind != N_HANDLE_SANDBOX || !h->sb) {
     napi_throw_error(env, NULL, "sandbox destroyed");
     return NULL;
   }
   return h;
 }
 
+/* Process getters accept either a sandbox (its one-shot child) or a child. */
+static sl_child_t* n_get_child(napi_env env, napi_value v) {
+  void* ptr = NULL;
+  NAPI_CALL(napi_get_value_external(env, v, &ptr));
+  if (ptr && *(n_handle_kind_t*)ptr == N_HANDLE_CHILD) {
+    n_child_handle_t* h = (n_child_handle_t*)ptr;
+    if (!h->child) {
+      napi_throw_error(env, NULL, "child destroyed");
+      return NULL;
+    }
+    return h->child;
+  }
+
+  n_sb_handle_t* h = n_get_handle(env, v);
+  return h ? &h->sb->child : NULL;
+}
+
 typedef struct {
   napi_value value;
   napi_value read;
@@ -122,6 +198,52 @@ static s32 sl_napi_copy_scope(napi_env napi, napi_value value, sl_scope_t* scope
   return 0;
 }
 
+/* "pipe" | "inherit" | "null" | "merge" | "memfd" | an fd; missing means a pipe */
+static const c8* n_copy_stdio_stream(napi_env env, napi_value object, const c8* name, sl_stdio_stream_t* stream) {
+  static const c8* bad = "stdio modes are 'pipe', 'inherit', 'null', 'merge', 'memfd' or an fd";
+
+  napi_value value = SL_ZERO;
+  napi_valuetype type = napi_undefined;
+  if (napi_get_named_property(env, object, name, &value) != napi_ok) return bad;
+  if (napi_typeof(env, value, &type) != napi_ok) return bad;
+
+  if (type == napi_undefined) {
+    *stream = (sl_stdio_stream_t){ .mode = SL_STDIO_PIPE };
+    return SL_NULLPTR;
+  }
+
+  if (type == napi_number) {
+    *stream = (sl_stdio_stream_t){ .mode = SL_STDIO_FD };
+    return napi_get_value_int32(env, value, &stream->fd) == napi_ok ? SL_NULLPTR : bad;
+  }
+
+  c8 mode[16] = SL_ZERO;
+  size_t len = 0;
+  if (type != napi_string || napi_get_value_string_utf8(env, value, mode, sizeof(mode), &len) != napi_ok) return bad;
+
+  if (!strcmp(mode, "pipe")) *stream = (sl_stdio_stream_t){ .mode = SL_STDIO_PIPE };
+  else if (!strcmp(mode, "inherit")) *stream = (sl_stdio_stream_t){ .mode = SL_STDIO_INHERIT };
+  else if (!strcmp(mode, "null")) *stream = (sl_stdio_stream_t){ .mode = SL_STDIO_NULL };
+  else if (!strcmp(mode, "merge")) *stream = (sl_stdio_stream_t){ .mode = SL_STDIO_MERGE };
+  else if (!strcmp(mode, "memfd")) *stream = (sl_stdio_stream_t){ .mode = SL_STDIO_MEMFD };
+  else return bad;
+  return SL_NULLPTR;
+}
+
+static const c8* n_copy_stdio(napi_env env, napi_value value, sl_stdio_t* stdio) {
+  *stdio = (sl_stdio_t)SL_ZERO;
+
+  napi_valuetype type = napi_undefined;
+  if (napi_typeof(env, value, &type) != napi_ok) return "stdio must be an object";
+  if (type == napi_undefined) return SL_NULLPTR;
+  if (type != napi_object) return "stdio must be an object";
+
+  const c8* msg = n_copy_stdio_stream(env, value, "stdin", &stdio->in);
+  if (!msg) msg = n_copy_stdio_stream(env, value, "stdout", &stdio->out);
+  if (!msg) msg = n_copy_stdio_stream(env, value, "stderr", &stdio->err);
+  return msg;
+}
+
 #define SL_NAPI_MAX_ARGS 8
 
 typedef struct {
@@ -181,6 +303,7 @@ static napi_value sl_napi_create(napi_env env, napi_callback_info info) {
     .write = SL_ZERO,
     .network = 0,
   };
+  s32* inherit_fds = SL_NULLPTR;
 
   if (!napi_get_named_property(env, v.value, "read", &v.read)) {
     if (sl_napi_copy_scope(env, v.read, &opts.read)) {
@@ -194,6 +317,15 @@ static napi_value sl_napi_create(napi_env env, napi_callback_info info) {
     }
   }
 
+  napi_value stdio = SL_ZERO;
+  if (napi_get_named_property(env, v.value, "stdio", &stdio) == napi_ok) {
+    const c8* msg = n_copy_stdio(env, stdio, &opts.stdio);
+    if (msg) {
+      napi_throw_error(env, NULL, msg);
+      goto done;
+    }
+  }
+
   if (napi_get_named_property(env, v.value, "network", &v.network) == napi_ok) {
     bool network = false;
     if (napi_get_value_bool(env, v.network, &network) != napi_ok) {
@@ -202,6 +334,45 @@ static napi_value sl_napi_create(napi_env env, napi_callback_info info) {
     opts.network = network ? 1 : 0;
   }
 
+  napi_value pipe_size = SL_ZERO;
+  if (napi_get_named_property(env, v.value, "pipeSize", &pipe_size) == napi_ok) {
+    napi_valuetype type = napi_undefined;
+    napi_typeof(env, pipe_size, &type);
+    s64 size = 0;
+    if (type != napi_undefined && napi_get_value_int64(env, pipe_size, &size) != napi_ok) {
+      goto done;
+    }
+    opts.pipe_size = size > 0 ? (u64)size : 0;
+  }
+
+  napi_value nonblock = SL_ZERO;
+  if (napi_get_named_property(env, v.value, "nonblock", &nonblock) == napi_ok) {
+    bool on = false;
+    napi_get_value_bool(env, nonblock, &on);
+    opts.pipe_flags = on ? SL_PIPE_NONBLOCK : 0;
+  }
+
+  napi_value inherit = SL_ZERO;
+  bool is_array = false;
+  if (napi_get_named_property(env, v.value, "inheritFds", &inherit) == napi_ok &&
+      napi_is_array(env, inherit, &is_array) == napi_ok && is_array) {
+    u32 len = 0;
+    napi_get_array_length(env, inherit, &len);
+    inherit_fds = sl_alloc_n(s32, len ? len : 1);
+    if (!inherit_fds) {
+      goto done;
+    }
+    sl_for(it, len) {
+      napi_value fd = SL_ZERO;
+      if (napi_get_element(env, inherit, it, &fd) != napi_ok || napi_get_value_int32(env, fd, &inherit_fds[it]) != napi_ok) {
+        napi_throw_type_error(env, NULL, "inheritFds must be an array of descriptors");
+        goto done;
+      }
+    }
+    opts.inherit_fds = inherit_fds;
+    opts.num_inherit_fds = len;
+  }
+
   sl_ctx_t* sb = sb_create(&opts);
   if (!sb) {
     goto done;
@@ -212,6 +383,7 @@ static napi_value sl_napi_create(napi_env env, napi_callback_info info) {
     sb_destroy(sb);
     goto done;
   }
+  handle->kind = N_HANDLE_SANDBOX;
   handle->sb = sb;
 
   if (napi_create_external(env, handle, n_finalize, NULL, &result) != napi_ok) {
@@ -222,13 +394,68 @@ static napi_value sl_napi_create(napi_env env, napi_callback_info info) {
 done:
   sl_napi_free_scope(&opts.write);
   sl_napi_free_scope(&opts.read);
+  sl_free(inherit_fds);
   return result;
 }
 
 ///////////
 // SPAWN //
 ///////////
-static napi_value n_spawn(napi_env env, napi_callback_info info) {
+/* Prefer the context's message (e.g. "execve(/bin/x): No such file..."). */
+static const c8* n_spawn_error(const sl_ctx_t* sb, sl_err_t err) {
+  const c8* msg = sb_error(sb);
+  return msg ? msg : sl_err_to_string(err);
+}
+
+/* Copies a JS array of strings; anything that isn't an array is no args. */
+static const c8* n_copy_args(napi_env env, napi_value value, c8*** out, u32* num_argv, u32* num_filled) {
+  c8** argv = SL_ZERO;
+  *num_argv = 0;
+  *num_filled = 0;
+
+  bool is_arr = false;
+  if (napi_is_array(env, value, &is_arr) != napi_ok) {
+    return "spawn args must be an array";
+  }
+
+  if (is_arr) {
+    if (napi_get_array_length(env, value, num_argv) != napi_ok) {
+      return "spawn args must be an array";
+    }
+  }
+
+  if (*num_argv) {
+    argv = sl_alloc_n(c8*, *num_argv);
+    if (!argv) {
+      return "failed to allocate spawn args";
+    }
+  }
+  *out = argv;
+
+  sl_for(it, *num_argv) {
+    napi_value element = SL_ZERO;
+    if (napi_get_element(env, value, it, &element) != napi_ok) {
+      return "spawn args must be strings";
+    }
+
+    c8* arg = SL_ZERO;
+    if (sl_napi_copy_str(env, element, &arg)) {
+      return "spawn args must be strings";
+    }
+
+    argv[it] = arg;
+    (*num_filled)++;
+  }
+
+  return SL_NULLPTR;
+}
+
+static void n_free_args(c8** argv, u32 num_filled) {
+  sl_for(it, num_filled) { sl_free(argv[it]); }
+  sl_free(argv);
+}
+
+static napi_value n_spawn_common(napi_env env, napi_callback_info info, bool as_child) {
   napi_value out = NULL;
   const c8* msg = SL_NULLPTR;
   c8* cmd = SL_ZERO;
@@ -254,58 +481,309 @@ static napi_value n_spawn(napi_env env, napi_callback_info info) {
     goto done;
   }
 
-  /* args array */
-  bool is_arr = false;
-  if (napi_is_array(env, args[2], &is_arr) != napi_ok) {
-    msg = "spawn args must be an array";
+  msg = n_copy_args(env, args[2], &argv, &num_argv, &num_filled);
+  if (msg) {
     goto done;
   }
 
-  if (is_arr) {
-    if (napi_get_array_length(env, args[2], &num_argv) != napi_ok) {
-      msg = "spawn args must be an array";
+  if (!as_child) {
+    sl_err_t err = sb_spawn(sb, cmd, (const c8* const*)argv, num_argv, NULL);
+    if (err) {
+      msg = n_spawn_error(sb, err);
       goto done;
     }
+
+    if (napi_get_undefined(env, &out) != napi_ok) {
+      out = NULL;
+    }
   }
 
-  if (num_argv) {
-    argv = sl_alloc_n(c8*, num_argv);
-    if (!argv) {
-      msg = "failed to allocate spawn args";
+  if (as_child) {
+    n_child_handle_t* child = sl_alloc_t(n_child_handle_t);
+    if (!child) {
+      msg = "failed to allocate child handle";
       goto done;
     }
+    child->kind = N_HANDLE_CHILD;
+
+    sl_err_t err = sb_spawn_child(sb, cmd, (const c8* const*)argv, num_argv, NULL, &child->child);
+    if (err) {
+      sl_free(child);
+      msg = n_spawn_error(sb, err);
+      goto done;
+    }
+
+    if (napi_create_external(env, child, n_finalize, NULL, &out) != napi_ok) {
+      n_finalize(env, child, NULL);
+      msg = "failed to create child handle";
+      goto done;
+    }
+  }
+
+done:
+  n_free_args(argv, num_filled);
+  sl_free(cmd);
+
+  if (msg) {
+    napi_throw_error(env, NULL, msg);
+    return NULL;
+  }
+
+  return out;
+}
+
+static napi_value n_spawn(napi_env env, napi_callback_info info) {
+  return n_spawn_common(env, info, false);
+}
+
+static napi_value n_spawn_child(napi_env env, napi_callback_info info) {
+  return n_spawn_common(env, info, true);
+}
+
+typedef struct {
+  c8* cmd;
+  c8** argv;
+  u32 num_argv;
+  u32 num_filled;
+  sl_stdio_t stdio;
+} n_spawn_spec_t;
+
+/* spawnMany(handle, [{ cmd, args, stdio }]) -> child handle[] */
+static napi_value n_spawn_many(napi_env env, napi_callback_info info) {
+  napi_value out = NULL;
+  const c8* msg = SL_NULLPTR;
+  n_spawn_spec_t* specs = SL_ZERO;
+  sb_spawn_spec_t* sb_specs = SL_ZERO;
+  sl_child_t** children = SL_ZERO;
+  u32 num_specs = 0;
+
+  u64 num_args = 2;
+  napi_value args[2] = SL_ZERO;
+  if (napi_get_cb_info(env, info, &num_args, args, NULL, NULL) != napi_ok) {
+    return NULL;
+  }
+
+  n_sb_handle_t* handle = n_get_handle(env, args[0]);
+  if (!handle) {
+    return SL_NULL;
+  }
+
+  bool is_arr = false;
+  if (napi_is_array(env, args[1], &is_arr) != napi_ok || !is_arr) {
+    msg = "spawnMany specs must be an array";
+    goto done;
+  }
+  if (napi_get_array_length(env, args[1], &num_specs) != napi_ok) {
+    msg = "spawnMany specs must be an array";
+    goto done;
+  }
+
+  specs = sl_alloc_n(n_spawn_spec_t, num_specs + 1);
+  sb_specs = sl_alloc_n(sb_spawn_spec_t, num_specs + 1);
+  children = sl_alloc_n(sl_child_t*, num_specs + 1);
+  if (!specs || !sb_specs || !children) {
+    msg = "failed to allocate spawn specs";
+    goto done;
   }
 
-  sl_for(it, num_argv) {
+  sl_for(it, num_specs) {
+    specs[it] = (n_spawn_spec_t)SL_ZERO;
+    children[it] = SL_NULLPTR;
+  }
+
+  sl_for(it, num_specs) {
+    napi_value spec = SL_ZERO;
     napi_value value = SL_ZERO;
-    if (napi_get_element(env, args[2], it, &value) != napi_ok) {
-      msg = "spawn args must be strings";
+    if (napi_get_element(env, args[1], it, &spec) != napi_ok) {
+      msg = "spawnMany specs must be objects";
       goto done;
     }
 
-    c8* arg = SL_ZERO;
-    if (sl_napi_copy_str(env, value, &arg)) {
-      msg = "spawn args must be strings";
+    if (napi_get_named_property(env, spec, "cmd", &value) != napi_ok || sl_napi_copy_str(env, value, &specs[it].cmd)) {
+      msg = "spawn command must be a string";
       goto done;
     }
 
-    argv[it] = arg;
-    num_filled++;
+    if (napi_get_named_property(env, spec, "args", &value) != napi_ok) {
+      msg = "spawn args must be an array";
+      goto done;
+    }
+
+    msg = n_copy_args(env, value, &specs[it].argv, &specs[it].num_argv, &specs[it].num_filled);
+    if (msg) {
+      goto done;
+    }
+
+    /* A spec without stdio uses the sandbox's */
+    bool has_stdio = false;
+    if (napi_has_named_property(env, spec, "stdio", &has_stdio) != napi_ok ||
+        (has_stdio && napi_get_named_property(env, spec, "stdio", &value) != napi_ok)) {
+      msg = "stdio must be an object";
+      goto done;
+    }
+    if (has_stdio) {
+      msg = n_copy_stdio(env, value, &specs[it].stdio);
+      if (msg) {
+        goto done;
+      }
+    }
+
+    sb_specs[it] = (sb_spawn_spec_t) {
+      .cmd = specs[it].cmd,
+      .args = (const c8* const*)specs[it].argv,
+      .num_args = specs[it].num_argv,
+      .stdio = has_stdio ? &specs[it].stdio : SL_NULLPTR,
+    };
   }
 
-  sl_err_t err = sb_spawn(sb, cmd, (const c8* const*)argv, num_argv, NULL);
+  sl_err_t err = sb_spawn_many(handle->sb, sb_specs, num_specs, children);
   if (err) {
-    msg = sl_err_to_string(err);
+    msg = n_spawn_error(handle->sb, err);
+    goto done;
+  }
+
+  if (napi_create_array_with_length(env, num_specs, &out) != napi_ok) {
+    msg = "failed to create child handles";
     goto done;
   }
 
-  if (napi_get_undefined(env, &out) != napi_ok) {
-    out = NULL;
+  /* from here on each child is owned by its external, or destroyed below */
+  sl_for(it, num_specs) {
+    n_child_handle_t* child = sl_alloc_t(n_child_handle_t);
+    napi_value value = SL_ZERO;
+    if (child) {
+      child->kind = N_HANDLE_CHILD;
+      child->child = children[it];
+      children[it] = SL_NULLPTR;
+      if (napi_create_external(env, child, n_finalize, NULL, &value) != napi_ok) {
+        n_finalize(env, child, NULL);
+        child = SL_NULLPTR;
+      }
+    }
+
+    if (!child || napi_set_element(env, out, it, value) != napi_ok) {
+      msg = "failed to create child handles";
+      goto done;
+    }
   }
 
 done:
-  sl_for(it, num_filled) { sl_free(argv[it]); }
-  sl_free(argv);
+  if (specs) {
+    sl_for(it, num_specs) {
+      n_free_args(specs[it].argv, specs[it].num_filled);
+      sl_free(specs[it].cmd);
+    }
+  }
+  if (children) {
+    sl_for(it, num_specs) { sb_child_destroy(children[it]); }
+  }
+  sl_free(children);
+  sl_free(sb_specs);
+  sl_free(specs);
+
+  if (msg) {
+    napi_throw_error(env, NULL, msg);
+    return NULL;
+  }
+
+  return out;
+}
+
+/* --- serverCreate(sandbox), serverSpawn(sandbox, server, cmd, args) ----- */
+
+/*
+ * A server borrows its sandbox's context, so spawns name both: the sandbox is
+ * kept reachable for as long as the server is used, and a destroyed one is
+ * caught here instead of inside the server.
+ */
+
+static napi_value n_server_create(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  n_sb_handle_t* owner = n_get_handle(env, argv[0]);
+  if (!owner) return NULL;
+
+  n_server_handle_t* h = sl_alloc_t(n_server_handle_t);
+  if (!h) {
+    napi_throw_error(env, NULL, "failed to allocate fork server");
+    return NULL;
+  }
+
+  *h = (n_server_handle_t){ .kind = N_HANDLE_SERVER, .server = sb_server_create(owner->sb), .owner = owner };
+  if (!h->server) {
+    sl_free(h);
+    const c8* msg = sb_error(owner->sb);
+    napi_throw_error(env, NULL, msg ? msg : "failed to start fork server");
+    return NULL;
+  }
+
+  napi_value result;
+  if (napi_create_external(env, h, n_finalize, NULL, &result) != napi_ok) {
+    n_finalize(env, h, NULL);
+    napi_throw_error(env, NULL, "failed to create fork server handle");
+    return NULL;
+  }
+  return result;
+}
+
+static napi_value n_server_spawn(napi_env env, napi_callback_info info) {
+  napi_value out = NULL;
+  const c8* msg = SL_NULLPTR;
+  c8* cmd = SL_ZERO;
+  c8** argv = SL_ZERO;
+  u32 num_argv = SL_ZERO;
+  u32 num_filled = SL_ZERO;
+
+  size_t num_args = 4;
+  napi_value args[4] = SL_ZERO;
+  NAPI_CALL(napi_get_cb_info(env, info, &num_args, args, NULL, NULL));
+
+  n_sb_handle_t* owner = n_get_handle(env, args[0]);
+  if (!owner) return NULL;
+
+  n_server_handle_t* h = NULL;
+  NAPI_CALL(napi_get_value_external(env, args[1], (void**)&h));
+  if (!h || h->kind != N_HANDLE_SERVER || !h->server) {
+    napi_throw_error(env, NULL, "fork server destroyed");
+    return NULL;
+  }
+  if (h->owner != owner) {
+    napi_throw_error(env, NULL, "fork server belongs to another sandbox");
+    return NULL;
+  }
+
+  if (sl_napi_copy_str(env, args[2], &cmd)) {
+    msg = "spawn command must be a string";
+    goto done;
+  }
+
+  msg = n_copy_args(env, args[3], &argv, &num_argv, &num_filled);
+  if (msg) {
+    goto done;
+  }
+
+  n_child_handle_t* child = sl_alloc_t(n_child_handle_t);
+  if (!child) {
+    msg = "failed to allocate child handle";
+    goto done;
+  }
+  child->kind = N_HANDLE_CHILD;
+
+  sl_err_t err = sb_server_spawn(h->server, cmd, (const c8* const*)argv, num_argv, NULL, &child->child);
+  if (err) {
+    sl_free(child);
+    msg = n_spawn_error(owner->sb, err);
+    goto done;
+  }
+
+  if (napi_create_external(env, child, n_finalize, NULL, &out) != napi_ok) {
+    n_finalize(env, child, NULL);
+    msg = "failed to create child handle";
+  }
+
+done:
+  n_free_args(argv, num_filled);
   sl_free(cmd);
 
   if (msg) {
@@ -322,10 +800,10 @@ static napi_value n_pid(napi_env env, napi_callback_info info) {
   size_t argc = 1;
   napi_value argv[1];
   NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
-  n_sb_handle_t* h = n_get_handle(env, argv[0]);
-  if (!h) return NULL;
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
   napi_value result;
-  NAPI_CALL(napi_create_int32(env, sb_pid(h->sb), &result));
+  NAPI_CALL(napi_create_int32(env, sb_child_pid(child), &result));
   return result;
 }
 
@@ -333,10 +811,10 @@ static napi_value n_stdin_fd(napi_env env, napi_callback_info info) {
   size_t argc = 1;
   napi_value argv[1];
   NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
-  n_sb_handle_t* h = n_get_handle(env, argv[0]);
-  if (!h) return NULL;
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
   napi_value result;
-  NAPI_CALL(napi_create_int32(env, sb_stdin_fd(h->sb), &result));
+  NAPI_CALL(napi_create_int32(env, sb_child_stdin_fd(child), &result));
   return result;
 }
 
@@ -344,10 +822,10 @@ static napi_value n_stdout_fd(napi_env env, napi_callback_info info) {
   size_t argc = 1;
   napi_value argv[1];
   NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
-  n_sb_handle_t* h = n_get_handle(env, argv[0]);
-  if (!h) return NULL;
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
   napi_value result;
-  NAPI_CALL(napi_create_int32(env, sb_stdout_fd(h->sb), &result));
+  NAPI_CALL(napi_create_int32(env, sb_child_stdout_fd(child), &result));
   return result;
 }
 
@@ -355,10 +833,21 @@ static napi_value n_stderr_fd(napi_env env, napi_callback_info info) {
   size_t argc = 1;
   napi_value argv[1];
   NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
-  n_sb_handle_t* h = n_get_handle(env, argv[0]);
-  if (!h) return NULL;
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+  napi_value result;
+  NAPI_CALL(napi_create_int32(env, sb_child_stderr_fd(child), &result));
+  return result;
+}
+
+static napi_value n_pidfd(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
   napi_value result;
-  NAPI_CALL(napi_create_int32(env, sb_stderr_fd(h->sb), &result));
+  NAPI_CALL(napi_create_int32(env, sb_child_pidfd(child), &result));
   return result;
 }
 
@@ -368,11 +857,11 @@ static napi_value n_wait(napi_env env, napi_callback_info info) {
   size_t argc = 1;
   napi_value argv[1];
   NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
-  n_sb_handle_t* h = n_get_handle(env, argv[0]);
-  if (!h) return NULL;
-  int code = sb_wait(h->sb);
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+  int code = sb_child_wait(child);
   if (code < 0) {
-    napi_throw_error(env, NULL, sb_error(h->sb));
+    napi_throw_error(env, NULL, sb_child_error(child));
     return NULL;
   }
   napi_value result;
@@ -380,18 +869,995 @@ static napi_value n_wait(napi_env env, napi_callback_info info) {
   return result;
 }
 
-/* --- kill(handle, signal) ----------------------------------------------- */
+/* --- tryWait(handle), waitTimeout(handle, ms) ---------------------------- */
 
-static napi_value n_kill(napi_env env, napi_callback_info info) {
-  size_t argc = 2;
-  napi_value argv[2];
-  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
-  n_sb_handle_t* h = n_get_handle(env, argv[0]);
-  if (!h) return NULL;
-  int sig;
-  NAPI_CALL(napi_get_value_int32(env, argv[1], &sig));
-  if (sb_kill(h->sb, sig) != 0) {
-    napi_throw_error(env, NULL, sb_error(h->sb));
+/* Exit code, or null while the child is still running. */
+static napi_value n_wait_result(napi_env env, sl_child_t* child, int code) {
+  napi_value result;
+  if (code == SL_CHILD_RUNNING) {
+    NAPI_CALL(napi_get_null(env, &result));
+    return result;
+  }
+  if (code < 0) {
+    napi_throw_error(env, NULL, sb_child_error(child));
+    return NULL;
+  }
+  NAPI_CALL(napi_create_int32(env, code, &result));
+  return result;
+}
+
+static napi_value n_try_wait(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+  return n_wait_result(env, child, sb_child_try_wait(child));
+}
+
+static napi_value n_wait_timeout(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+  int ms;
+  NAPI_CALL(napi_get_value_int32(env, argv[1], &ms));
+  return n_wait_result(env, child, sb_child_wait_timeout(child, ms));
+}
+
+/* --- waitAsync(handle), readAsync(handle, stream, buffer) ---------------- */
+
+/*
+ * One poller thread per env serves every pending async call. It never
+ * touches an sl_child_t: it polls dups of the child's descriptors (the pidfd
+ * for exits, the pipe for reads and writes) and hands the waiter back to the
+ * JS thread, which reaps, reads or writes and settles the promise there. Without pidfds, exits
+ * are peeked with waitid(WNOWAIT) on a short tick. A waiter holds references
+ * to its handle (and buffer) so both outlive a dropped Child.
+ */
+#define N_POLLER_TICK_MS 10
+
+typedef enum {
+  N_WAIT_EXIT = 0,
+  N_WAIT_READ = 1,
+  N_WAIT_READY = 2,
+  N_WAIT_WRITE = 3,
+} n_wait_kind_t;
+
+typedef enum {
+  N_STREAM_STDOUT = 1,
+  N_STREAM_STDERR = 2,
+} n_stream_t;
+
+typedef struct n_waiter_t {
+  struct n_waiter_t* next;
+  n_wait_kind_t kind;
+  napi_deferred deferred;
+  napi_ref ref;
+  void* handle;
+  s32 pid;
+  s32 fd;
+
+  napi_ref buffer_ref;
+  void* data;
+  size_t len;
+  size_t done;
+  n_stream_t stream;
+} n_waiter_t;
+
+typedef struct {
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  napi_threadsafe_function tsfn;
+  n_waiter_t* pending;
+  u32 num_active;
+  s32 wake[2];
+  bool started;
+  bool stopping;
+} n_poller_t;
+
+static void n_waiter_free(n_waiter_t* waiter) {
+  if (waiter->fd >= 0) close(waiter->fd);
+  sl_free(waiter);
+}
+
+static bool n_waiter_ready(const n_waiter_t* waiter, const struct pollfd* pfd) {
+  if (waiter->fd >= 0) {
+    return pfd->revents != 0;
+  }
+
+  /* Leaves the zombie for the JS thread to reap. ECHILD means someone already
+   * did, which is just as final. */
+  siginfo_t info = SL_ZERO;
+  if (waitid(P_PID, (id_t)waiter->pid, &info, WEXITED | WNOHANG | WNOWAIT) < 0) {
+    return true;
+  }
+  return info.si_pid != 0;
+}
+
+static void n_poller_wake(n_poller_t* poller) {
+  ssize_t n = write(poller->wake[1], "x", 1);
+  (void)n;
+}
+
+static void n_poller_push(n_poller_t* poller, n_waiter_t* waiter) {
+  pthread_mutex_lock(&poller->mutex);
+  waiter->next = poller->pending;
+  poller->pending = waiter;
+  pthread_mutex_unlock(&poller->mutex);
+  n_poller_wake(poller);
+}
+
+static void* n_poller_main(void* userdata) {
+  n_poller_t* poller = (n_poller_t*)userdata;
+  struct pollfd* pfds = SL_NULLPTR;
+  n_waiter_t** watched = SL_NULLPTR;
+  u32 capacity = 0;
+
+  while (true) {
+    pthread_mutex_lock(&poller->mutex);
+    if (poller->stopping) {
+      pthread_mutex_unlock(&poller->mutex);
+      break;
+    }
+
+    u32 num_waiters = 0;
+    for (n_waiter_t* w = poller->pending; w; w = w->next) num_waiters++;
+
+    if (num_waiters + 1 > capacity) {
+      capacity = (num_waiters + 1) * 2;
+      sl_free(pfds);
+      sl_free(watched);
+      pfds = sl_alloc_n(struct pollfd, capacity);
+      watched = sl_alloc_n(n_waiter_t*, capacity);
+    }
+    if (!pfds || !watched) {
+      pthread_mutex_unlock(&poller->mutex);
+      break;
+    }
+
+    /* Slot 0 is the wake pipe; exit waiters without a pidfd get a dead slot. */
+    u32 num_fds = 0;
+    bool needs_tick = false;
+    pfds[num_fds++] = (struct pollfd){ .fd = poller->wake[0], .events = POLLIN };
+    for (n_waiter_t* w = poller->pending; w; w = w->next) {
+      watched[num_fds] = w;
+      pfds[num_fds++] = (struct pollfd){ .fd = w->fd, .events = w->kind == N_WAIT_WRITE ? POLLOUT : POLLIN };
+      if (w->fd < 0) needs_tick = true;
+    }
+    pthread_mutex_unlock(&poller->mutex);
+
+    s32 n = poll(pfds, num_fds, needs_tick ? N_POLLER_TICK_MS : -1);
+    if (n < 0 && errno != EINTR) break;
+
+    if (pfds[0].revents) {
+      c8 drain[64];
+      while (read(poller->wake[0], drain, sizeof(drain)) > 0) {}
+    }
+
+    /* Waiters are only ever unlinked here, so `watched` is still valid. */
+    pthread_mutex_lock(&poller->mutex);
+    for (u32 it = 1; it < num_fds; it++) {
+      n_waiter_t* waiter = watched[it];
+      if (!n_waiter_ready(waiter, &pfds[it])) continue;
+
+      n_waiter_t** link = &poller->pending;
+      while (*link != waiter) link = &(*link)->next;
+      *link = waiter->next;
+      waiter->next = SL_NULLPTR;
+
+      napi_call_threadsafe_function(poller->tsfn, waiter, napi_tsfn_nonblocking);
+    }
+    pthread_mutex_unlock(&poller->mutex);
+  }
+
+  sl_free(pfds);
+  sl_free(watched);
+  return SL_NULLPTR;
+}
+
+static sl_child_t* n_waiter_child(const n_waiter_t* waiter) {
+  n_handle_kind_t kind = *(n_handle_kind_t*)waiter->handle;
+  if (kind == N_HANDLE_CHILD) return ((n_child_handle_t*)waiter->handle)->child;
+
+  n_sb_handle_t* h = (n_sb_handle_t*)waiter->handle;
+  return h->sb ? &h->sb->child : SL_NULLPTR;
+}
+
+static s32 n_child_stream_fd(const sl_child_t* child, n_stream_t stream) {
+  return stream == N_STREAM_STDERR ? sb_child_stderr_fd(child) : sb_child_stdout_fd(child);
+}
+
+/*
+ * One read() that can't block, without touching the descriptor's flags
+ * (callers may share it): RWF_NOWAIT says so per call. Where pipes don't
+ * accept it, a zero-timeout poll() has to, which holds as long as this is
+ * the only reader.
+ */
+static ssize_t n_read_nowait(s32 fd, void* data, size_t len) {
+#if defined(RWF_NOWAIT)
+  struct iovec iov = { .iov_base = data, .iov_len = len };
+  ssize_t n = preadv2(fd, &iov, 1, -1, RWF_NOWAIT);
+  if (n >= 0 || errno != EOPNOTSUPP) return n;
+#endif
+  struct pollfd pfd = { .fd = fd, .events = POLLIN };
+  if (poll(&pfd, 1, 0) == 0) {
+    errno = EAGAIN;
+    return -1;
+  }
+  return read(fd, data, len);
+}
+
+/* Large writes are vmspliced; a small one is cheaper to copy than to pin. */
+static u32 n_write_flags(size_t len) {
+  return len > SL_FORWARD_CHUNK ? SL_WRITE_GIFT | SL_WRITE_NONBLOCK : SL_WRITE_NONBLOCK;
+}
+
+/* Byte counts can pass 2 GiB, so results are int64 (exact as a JS number). */
+static void n_settle(napi_env env, napi_deferred deferred, s64 result, const c8* msg) {
+  napi_value value = SL_ZERO;
+  if (result >= 0) {
+    napi_create_int64(env, result, &value);
+    napi_resolve_deferred(env, deferred, value);
+    return;
+  }
+
+  napi_value text = SL_ZERO;
+  napi_create_string_utf8(env, msg, NAPI_AUTO_LENGTH, &text);
+  napi_create_error(env, NULL, text, &value);
+  napi_reject_deferred(env, deferred, value);
+}
+
+static void n_poller_settle(napi_env env, napi_value js_cb, void* context, void* data) {
+  (void)js_cb;
+  n_poller_t* poller = (n_poller_t*)context;
+  n_waiter_t* waiter = (n_waiter_t*)data;
+
+  /* env is NULL when the tsfn is torn down with calls still queued */
+  if (!env) {
+    n_waiter_free(waiter);
+    return;
+  }
+
+  sl_child_t* child = waiter->kind == N_WAIT_READY ? SL_NULLPTR : n_waiter_child(waiter);
+  s64 result = -1;
+  const c8* msg = "child destroyed";
+
+  /* The loop fd is readable; the caller polls it. */
+  if (waiter->kind == N_WAIT_READY) {
+    result = 0;
+  }
+
+  if (child && waiter->kind == N_WAIT_EXIT) {
+    result = sb_child_wait(child);
+    msg = sb_child_error(child);
+  }
+
+  if (child && waiter->kind == N_WAIT_READ) {
+    ssize_t n = n_read_nowait(n_child_stream_fd(child, waiter->stream), waiter->data, waiter->len);
+
+    /* Someone else drained the pipe first; go back to waiting. */
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+      n_poller_push(poller, waiter);
+      return;
+    }
+
+    result = (s64)n;
+    msg = strerror(errno);
+  }
+
+  if (child && waiter->kind == N_WAIT_WRITE) {
+    s64 n = sb_child_write_stdin(child, (u8*)waiter->data + waiter->done, waiter->len - waiter->done, n_write_flags(waiter->len));
+    if (n >= 0) waiter->done += (size_t)n;
+
+    /* Still no room for all of it; wait for the child to read some more. */
+    if (n >= 0 && waiter->done < waiter->len) {
+      n_poller_push(poller, waiter);
+      return;
+    }
+
+    result = n < 0 ? -1 : (s64)waiter->done;
+    msg = sb_child_error(child);
+  }
+
+  n_settle(env, waiter->deferred, result, msg ? msg : "wait failed");
+
+  napi_delete_reference(env, waiter->ref);
+  if (waiter->buffer_ref) napi_delete_reference(env, waiter->buffer_ref);
+  n_waiter_free(waiter);
+
+  /* Pending calls keep the process alive, like an unexited child_process. */
+  if (--poller->num_active == 0) {
+    napi_unref_threadsafe_function(env, poller->tsfn);
+  }
+}
+
+static void n_poller_finalize(napi_env env, void* data, void* hint) {
+  (void)env;
+  (void)hint;
+  n_poller_t* poller = (n_poller_t*)data;
+
+  if (poller->started) {
+    pthread_mutex_lock(&poller->mutex);
+    poller->stopping = true;
+    pthread_mutex_unlock(&poller->mutex);
+
+    n_poller_wake(poller);
+    pthread_join(poller->thread, SL_NULLPTR);
+    napi_release_threadsafe_function(poller->tsfn, napi_tsfn_abort);
+  }
+
+  while (poller->pending) {
+    n_waiter_t* waiter = poller->pending;
+    poller->pending = waiter->next;
+    n_waiter_free(waiter);
+  }
+
+  if (poller->wake[0] >= 0) close(poller->wake[0]);
+  if (poller->wake[1] >= 0) close(poller->wake[1]);
+  pthread_mutex_destroy(&poller->mutex);
+  sl_free(poller);
+}
+
+static n_poller_t* n_get_poller(napi_env env) {
+  n_poller_t* poller = SL_NULLPTR;
+  if (napi_get_instance_data(env, (void**)&poller) == napi_ok && poller && poller->started) {
+    return poller;
+  }
+
+  if (!poller) {
+    poller = sl_alloc_t(n_poller_t);
+    if (!poller) return SL_NULLPTR;
+    *poller = (n_poller_t){ .wake = { -1, -1 } };
+    pthread_mutex_init(&poller->mutex, SL_NULLPTR);
+    if (napi_set_instance_data(env, poller, n_poller_finalize, SL_NULLPTR) != napi_ok) {
+      n_poller_finalize(env, poller, SL_NULLPTR);
+      return SL_NULLPTR;
+    }
+  }
+
+  if (poller->wake[0] < 0) {
+    if (pipe(poller->wake)) return SL_NULLPTR;
+    sl_for(it, 2) {
+      fcntl(poller->wake[it], F_SETFD, FD_CLOEXEC);
+      fcntl(poller->wake[it], F_SETFL, O_NONBLOCK);
+    }
+  }
+
+  napi_value name = SL_ZERO;
+  if (napi_create_string_utf8(env, "stevelock.poller", NAPI_AUTO_LENGTH, &name) != napi_ok) return SL_NULLPTR;
+  if (napi_create_threadsafe_function(env, NULL, NULL, name, 0, 1, NULL, NULL, poller, n_poller_settle, &poller->tsfn) != napi_ok) {
+    return SL_NULLPTR;
+  }
+  napi_unref_threadsafe_function(env, poller->tsfn);
+
+  if (pthread_create(&poller->thread, SL_NULLPTR, n_poller_main, poller)) {
+    napi_release_threadsafe_function(poller->tsfn, napi_tsfn_abort);
+    return SL_NULLPTR;
+  }
+
+  poller->started = true;
+  return poller;
+}
+
+/* Queues `waiter` (already filled in, fd dup'd) behind a new promise. */
+static napi_value n_poller_enqueue(napi_env env, napi_value handle, n_waiter_t* waiter, napi_deferred deferred) {
+  n_poller_t* poller = n_get_poller(env);
+  if (!poller) {
+    n_waiter_free(waiter);
+    napi_throw_error(env, NULL, "failed to start poller");
+    return NULL;
+  }
+
+  waiter->deferred = deferred;
+  NAPI_CALL(napi_get_value_external(env, handle, &waiter->handle));
+  NAPI_CALL(napi_create_reference(env, handle, 1, &waiter->ref));
+
+  if (poller->num_active++ == 0) {
+    napi_ref_threadsafe_function(env, poller->tsfn);
+  }
+
+  n_poller_push(poller, waiter);
+  return handle;
+}
+
+static napi_value n_wait_async(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+
+  napi_deferred deferred;
+  napi_value promise;
+  NAPI_CALL(napi_create_promise(env, &deferred, &promise));
+
+  /* Already exited (or never spawned): settle without involving the poller */
+  s32 code = sb_child_try_wait(child);
+  if (code != SL_CHILD_RUNNING) {
+    const c8* msg = sb_child_error(child);
+    n_settle(env, deferred, code, msg ? msg : "not spawned");
+    return promise;
+  }
+
+  n_waiter_t* waiter = sl_alloc_t(n_waiter_t);
+  if (!waiter) {
+    napi_throw_error(env, NULL, "failed to allocate waiter");
+    return NULL;
+  }
+
+  *waiter = (n_waiter_t){
+    .kind = N_WAIT_EXIT,
+    .pid = sb_child_pid(child),
+    .fd = -1,
+  };
+  if (sb_child_pidfd(child) >= 0) {
+    waiter->fd = fcntl(sb_child_pidfd(child), F_DUPFD_CLOEXEC, 0);
+  }
+
+  if (!n_poller_enqueue(env, argv[0], waiter, deferred)) return NULL;
+  return promise;
+}
+
+/*
+ * Resolves with the number of bytes read into `buffer`, 0 at EOF. A read
+ * that can complete now does so on the JS thread; otherwise the pipe is
+ * handed to the poller. Only one read per stream should be in flight.
+ */
+static napi_value n_read_async(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value argv[3];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+
+  s32 stream = 0;
+  NAPI_CALL(napi_get_value_int32(env, argv[1], &stream));
+  if (stream != N_STREAM_STDOUT && stream != N_STREAM_STDERR) {
+    napi_throw_error(env, NULL, "stream must be 1 (stdout) or 2 (stderr)");
+    return NULL;
+  }
+
+  void* data = SL_NULLPTR;
+  size_t len = 0;
+  NAPI_CALL(napi_get_buffer_info(env, argv[2], &data, &len));
+
+  napi_deferred deferred;
+  napi_value promise;
+  NAPI_CALL(napi_create_promise(env, &deferred, &promise));
+
+  s32 fd = n_child_stream_fd(child, (n_stream_t)stream);
+  if (fd < 0) {
+    n_settle(env, deferred, -1, "not spawned");
+    return promise;
+  }
+
+  ssize_t n = n_read_nowait(fd, data, len);
+  if (n >= 0 || (errno != EAGAIN && errno != EINTR)) {
+    n_settle(env, deferred, (s64)n, strerror(errno));
+    return promise;
+  }
+
+  n_waiter_t* waiter = sl_alloc_t(n_waiter_t);
+  if (!waiter) {
+    napi_throw_error(env, NULL, "failed to allocate waiter");
+    return NULL;
+  }
+
+  *waiter = (n_waiter_t){
+    .kind = N_WAIT_READ,
+    .pid = sb_child_pid(child),
+    .fd = fcntl(fd, F_DUPFD_CLOEXEC, 0),
+    .data = data,
+    .len = len,
+    .stream = (n_stream_t)stream,
+  };
+  if (waiter->fd < 0) {
+    sl_free(waiter);
+    n_settle(env, deferred, -1, strerror(errno));
+    return promise;
+  }
+
+  NAPI_CALL(napi_create_reference(env, argv[2], 1, &waiter->buffer_ref));
+  if (!n_poller_enqueue(env, argv[0], waiter, deferred)) return NULL;
+  return promise;
+}
+
+/* --- writeAsync(handle, buffer), closeStdin(handle), stdinUnread(handle) - */
+
+/*
+ * Resolves with buffer.length once all of `buffer` is in the child's stdin
+ * pipe: as much as fits now, the rest each time the poller sees room. A
+ * buffer over SL_FORWARD_CHUNK is vmspliced (SL_WRITE_GIFT), so the caller
+ * keeps it alive and unchanged until stdinUnread() says the child has read
+ * past it; smaller ones are copied. The descriptor's flags are left alone.
+ * Only one write should be in flight.
+ */
+static napi_value n_write_async(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+
+  void* data = SL_NULLPTR;
+  size_t len = 0;
+  NAPI_CALL(napi_get_buffer_info(env, argv[1], &data, &len));
+
+  napi_deferred deferred;
+  napi_value promise;
+  NAPI_CALL(napi_create_promise(env, &deferred, &promise));
+
+  s32 fd = sb_child_stdin_fd(child);
+  if (fd < 0) {
+    n_settle(env, deferred, -1, "stdin is not a pipe");
+    return promise;
+  }
+
+  s64 n = sb_child_write_stdin(child, data, len, n_write_flags(len));
+  if (n < 0 || (size_t)n == len) {
+    n_settle(env, deferred, n, sb_child_error(child));
+    return promise;
+  }
+
+  n_waiter_t* waiter = sl_alloc_t(n_waiter_t);
+  if (!waiter) {
+    napi_throw_error(env, NULL, "failed to allocate waiter");
+    return NULL;
+  }
+
+  *waiter = (n_waiter_t){
+    .kind = N_WAIT_WRITE,
+    .pid = sb_child_pid(child),
+    .fd = fcntl(fd, F_DUPFD_CLOEXEC, 0),
+    .data = data,
+    .len = len,
+    .done = (size_t)n,
+  };
+  if (waiter->fd < 0) {
+    sl_free(waiter);
+    n_settle(env, deferred, -1, strerror(errno));
+    return promise;
+  }
+
+  NAPI_CALL(napi_create_reference(env, argv[1], 1, &waiter->buffer_ref));
+  if (!n_poller_enqueue(env, argv[0], waiter, deferred)) return NULL;
+  return promise;
+}
+
+static napi_value n_close_stdin(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+
+  if (sb_child_close_stdin(child) != SL_OK) {
+    napi_throw_error(env, NULL, sb_child_error(child));
+    return NULL;
+  }
+  napi_value undef;
+  napi_get_undefined(env, &undef);
+  return undef;
+}
+
+/* Bytes written to stdin that the child has yet to read; 0 once it is closed. */
+static napi_value n_stdin_unread(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+
+  s32 unread = 0;
+  s32 fd = sb_child_stdin_fd(child);
+  if (fd >= 0 && ioctl(fd, FIONREAD, &unread)) unread = 0;
+
+  napi_value result;
+  NAPI_CALL(napi_create_int32(env, unread, &result));
+  return result;
+}
+
+/* --- forward(handle, stream, fd, tee), forwardWait(handle, stream) ------- */
+
+static napi_value n_forward(napi_env env, napi_callback_info info) {
+  size_t argc = 4;
+  napi_value argv[4];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+
+  s32 stream = 0;
+  s32 fd = -1;
+  bool tee = false;
+  NAPI_CALL(napi_get_value_int32(env, argv[1], &stream));
+  NAPI_CALL(napi_get_value_int32(env, argv[2], &fd));
+  if (argc > 3) napi_get_value_bool(env, argv[3], &tee);
+
+  if (sb_child_forward(child, (sl_stream_t)stream, fd, tee ? SL_FORWARD_TEE : 0) != SL_OK) {
+    napi_throw_error(env, NULL, sb_child_error(child));
+    return NULL;
+  }
+  napi_value undef;
+  napi_get_undefined(env, &undef);
+  return undef;
+}
+
+/*
+ * Joins the forwarder, so it blocks until the stream hits EOF; call it once
+ * the child has exited. Returns { bytes, copy } with copy a Buffer (tee) or
+ * null.
+ */
+static napi_value n_forward_wait(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+
+  s32 stream = 0;
+  NAPI_CALL(napi_get_value_int32(env, argv[1], &stream));
+
+  sl_forward_result_t forwarded = SL_ZERO;
+  if (sb_child_forward_wait(child, (sl_stream_t)stream, &forwarded) != SL_OK) {
+    sl_free(forwarded.copy);
+    napi_throw_error(env, NULL, sb_child_error(child));
+    return NULL;
+  }
+
+  napi_value result, bytes, copy;
+  napi_status status = napi_create_object(env, &result);
+  if (status == napi_ok) status = napi_create_double(env, (f64)forwarded.bytes, &bytes);
+  if (status == napi_ok && forwarded.copy) {
+    void* data = SL_NULLPTR;
+    status = napi_create_buffer_copy(env, forwarded.copy_len, forwarded.copy, &data, &copy);
+  }
+  if (status == napi_ok && !forwarded.copy) status = napi_get_null(env, &copy);
+  sl_free(forwarded.copy);
+
+  NAPI_CALL(status);
+  NAPI_CALL(napi_set_named_property(env, result, "bytes", bytes));
+  NAPI_CALL(napi_set_named_property(env, result, "copy", copy));
+  return result;
+}
+
+/* --- capture(handle, stream, opts), captureWait(handle, stream) ---------- */
+
+/* A non-negative number property, or 0 when it's missing. */
+static napi_status n_get_size(napi_env env, napi_value object, const c8* name, u64* out) {
+  napi_value value;
+  napi_valuetype type = napi_undefined;
+  f64 number = 0;
+  *out = 0;
+
+  napi_status status = napi_get_named_property(env, object, name, &value);
+  if (status == napi_ok) status = napi_typeof(env, value, &type);
+  if (status != napi_ok || type == napi_undefined) return status;
+  status = napi_get_value_double(env, value, &number);
+  if (status == napi_ok && number > 0) *out = (u64)number;
+  return status;
+}
+
+/* capture(handle, stream, { head, tail, quota }) */
+static napi_value n_capture(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value argv[3];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+
+  s32 stream = 0;
+  NAPI_CALL(napi_get_value_int32(env, argv[1], &stream));
+
+  sl_capture_opts_t opts = SL_ZERO;
+  NAPI_CALL(n_get_size(env, argv[2], "head", &opts.head));
+  NAPI_CALL(n_get_size(env, argv[2], "tail", &opts.tail));
+  NAPI_CALL(n_get_size(env, argv[2], "quota", &opts.quota));
+
+  if (sb_child_capture(child, (sl_stream_t)stream, &opts) != SL_OK) {
+    napi_throw_error(env, NULL, sb_child_error(child));
+    return NULL;
+  }
+  napi_value undef;
+  napi_get_undefined(env, &undef);
+  return undef;
+}
+
+static napi_status n_create_buffer_or_empty(napi_env env, const u8* data, u64 len, napi_value* out) {
+  void* copy = SL_NULLPTR;
+  return napi_create_buffer_copy(env, len, len ? data : (const u8*)"", &copy, out);
+}
+
+/* Like forwardWait, joins; returns { head, tail, total, overQuota }. */
+static napi_value n_capture_wait(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+
+  s32 stream = 0;
+  NAPI_CALL(napi_get_value_int32(env, argv[1], &stream));
+
+  sl_capture_t captured = SL_ZERO;
+  if (sb_child_capture_wait(child, (sl_stream_t)stream, &captured) != SL_OK) {
+    sl_free(captured.head);
+    sl_free(captured.tail);
+    napi_throw_error(env, NULL, sb_child_error(child));
+    return NULL;
+  }
+
+  napi_value result, head, tail, total, over_quota;
+  napi_status status = napi_create_object(env, &result);
+  if (status == napi_ok) status = n_create_buffer_or_empty(env, captured.head, captured.head_len, &head);
+  if (status == napi_ok) status = n_create_buffer_or_empty(env, captured.tail, captured.tail_len, &tail);
+  if (status == napi_ok) status = napi_create_double(env, (f64)captured.total, &total);
+  if (status == napi_ok) status = napi_get_boolean(env, captured.over_quota, &over_quota);
+  sl_free(captured.head);
+  sl_free(captured.tail);
+
+  NAPI_CALL(status);
+  NAPI_CALL(napi_set_named_property(env, result, "head", head));
+  NAPI_CALL(napi_set_named_property(env, result, "tail", tail));
+  NAPI_CALL(napi_set_named_property(env, result, "total", total));
+  NAPI_CALL(napi_set_named_property(env, result, "overQuota", over_quota));
+  return result;
+}
+
+/* --- outputBuffer(handle, stream) ---------------------------------------- */
+
+static void n_output_finalize(napi_env env, void* data, void* hint) {
+  (void)env;
+  (void)data;
+  sl_output_t* output = (sl_output_t*)hint;
+  sb_output_unmap(output);
+  sl_free(output);
+}
+
+/*
+ * A "memfd" stream of an exited child as an external ArrayBuffer over the
+ * mapping itself; it is unmapped when the ArrayBuffer is collected.
+ */
+static napi_value n_output_buffer(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+
+  s32 stream = 0;
+  NAPI_CALL(napi_get_value_int32(env, argv[1], &stream));
+
+  sl_output_t* output = sl_alloc_t(sl_output_t);
+  if (!output) {
+    napi_throw_error(env, NULL, "failed to allocate output");
+    return NULL;
+  }
+  if (sb_child_output_map(child, (sl_stream_t)stream, output) != SL_OK) {
+    sl_free(output);
+    napi_throw_error(env, NULL, sb_child_error(child));
+    return NULL;
+  }
+
+  napi_value result;
+  if (!output->data) {
+    sl_free(output);
+    void* data = SL_NULLPTR;
+    NAPI_CALL(napi_create_arraybuffer(env, 0, &data, &result));
+    return result;
+  }
+
+  napi_status status = napi_create_external_arraybuffer(env, output->data, output->len, n_output_finalize, output, &result);
+  if (status != napi_ok) {
+    n_output_finalize(env, SL_NULLPTR, output);
+    NAPI_CALL(status);
+  }
+  return result;
+}
+
+/* --- loopCreate(), loopAdd/loopRemove/loopPoll/loopWait(loop, ...) ------- */
+
+static sl_loop_t* n_get_loop(napi_env env, napi_value v) {
+  n_loop_handle_t* h = NULL;
+  NAPI_CALL(napi_get_value_external(env, v, (void**)&h));
+  if (!h || h->kind != N_HANDLE_LOOP || !h->loop) {
+    napi_throw_error(env, NULL, "loop destroyed");
+    return NULL;
+  }
+  return h->loop;
+}
+
+static const c8* n_loop_backend_names[] = { "auto", "poll", "io_uring" };
+
+/* loopCreate(backend?): "auto" (default), "poll" or "io_uring". */
+static napi_value n_loop_create(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+
+  sb_loop_opts_t opts = SL_ZERO;
+  napi_valuetype type = napi_undefined;
+  if (argc >= 1) NAPI_CALL(napi_typeof(env, argv[0], &type));
+  if (type != napi_undefined) {
+    c8 name[16] = SL_ZERO;
+    size_t len = 0;
+    bool known = false;
+    if (type == napi_string) NAPI_CALL(napi_get_value_string_utf8(env, argv[0], name, sizeof(name), &len));
+    sl_for(it, 3) {
+      if (strcmp(name, n_loop_backend_names[it])) continue;
+      opts.backend = (sl_loop_backend_t)it;
+      known = true;
+    }
+    if (!known) {
+      napi_throw_type_error(env, NULL, "backend must be \"auto\", \"poll\" or \"io_uring\"");
+      return NULL;
+    }
+  }
+
+  n_loop_handle_t* h = sl_alloc_t(n_loop_handle_t);
+  if (!h) {
+    napi_throw_error(env, NULL, "failed to allocate loop");
+    return NULL;
+  }
+
+  *h = (n_loop_handle_t){ .kind = N_HANDLE_LOOP, .loop = sb_loop_create(&opts) };
+  if (!h->loop) {
+    sl_free(h);
+    napi_throw_error(env, NULL, strerror(errno));
+    return NULL;
+  }
+
+  napi_value result;
+  if (napi_create_external(env, h, n_finalize, NULL, &result) != napi_ok) {
+    n_finalize(env, h, NULL);
+    napi_throw_error(env, NULL, "failed to create loop handle");
+    return NULL;
+  }
+  return result;
+}
+
+/* loopAdd(loop, handle, id): events for the child carry `id`. */
+static napi_value n_loop_add(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value argv[3];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_loop_t* loop = n_get_loop(env, argv[0]);
+  if (!loop) return NULL;
+  sl_child_t* child = n_get_child(env, argv[1]);
+  if (!child) return NULL;
+
+  u32 id = 0;
+  NAPI_CALL(napi_get_value_uint32(env, argv[2], &id));
+  if (sb_loop_add_child(loop, child, (void*)(uintptr_t)id) != SL_OK) {
+    napi_throw_error(env, NULL, sb_loop_error(loop));
+    return NULL;
+  }
+  napi_value undef;
+  napi_get_undefined(env, &undef);
+  return undef;
+}
+
+/* loopBackend(loop): what loopCreate() ended up with, "poll" or "io_uring". */
+static napi_value n_loop_backend(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_loop_t* loop = n_get_loop(env, argv[0]);
+  if (!loop) return NULL;
+
+  napi_value result;
+  NAPI_CALL(napi_create_string_utf8(env, n_loop_backend_names[sb_loop_backend(loop)], NAPI_AUTO_LENGTH, &result));
+  return result;
+}
+
+static napi_value n_loop_remove(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_loop_t* loop = n_get_loop(env, argv[0]);
+  if (!loop) return NULL;
+  sl_child_t* child = n_get_child(env, argv[1]);
+  if (!child) return NULL;
+
+  sb_loop_remove_child(loop, child);
+  napi_value undef;
+  napi_get_undefined(env, &undef);
+  return undef;
+}
+
+/*
+ * Never blocks: whatever is ready now, as [{ kind, id, data, code, last }]
+ * with kind 1 (stdout), 2 (stderr) or 3 (exit). data is null at EOF; last
+ * marks the child's final event.
+ */
+static napi_value n_loop_poll(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_loop_t* loop = n_get_loop(env, argv[0]);
+  if (!loop) return NULL;
+
+  sl_loop_event_t events[SL_LOOP_MAX_READY];
+  s32 n = sb_loop_poll(loop, events, SL_LOOP_MAX_READY, 0);
+  if (n < 0) {
+    napi_throw_error(env, NULL, sb_loop_error(loop));
+    return NULL;
+  }
+
+  napi_value result;
+  NAPI_CALL(napi_create_array_with_length(env, (size_t)n, &result));
+  sl_for(it, (u32)n) {
+    sl_loop_event_t* event = &events[it];
+    napi_value object, kind, id, data, code, last;
+    NAPI_CALL(napi_create_object(env, &object));
+    NAPI_CALL(napi_create_int32(env, (s32)event->kind, &kind));
+    NAPI_CALL(napi_create_uint32(env, (u32)(uintptr_t)event->user, &id));
+    NAPI_CALL(napi_get_null(env, &data));
+    NAPI_CALL(napi_get_null(env, &code));
+    NAPI_CALL(napi_get_boolean(env, event->last, &last));
+    if (event->len) {
+      void* copy = SL_NULLPTR;
+      NAPI_CALL(napi_create_buffer_copy(env, event->len, event->data, &copy, &data));
+    }
+    if (event->kind == SL_LOOP_EXIT) {
+      NAPI_CALL(napi_create_int32(env, event->exit_code, &code));
+    }
+    NAPI_CALL(napi_set_named_property(env, object, "kind", kind));
+    NAPI_CALL(napi_set_named_property(env, object, "id", id));
+    NAPI_CALL(napi_set_named_property(env, object, "data", data));
+    NAPI_CALL(napi_set_named_property(env, object, "code", code));
+    NAPI_CALL(napi_set_named_property(env, object, "last", last));
+    NAPI_CALL(napi_set_element(env, result, it, object));
+  }
+  return result;
+}
+
+/* Resolves once loopPoll has something; the poller watches the loop's fd. */
+static napi_value n_loop_wait(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_loop_t* loop = n_get_loop(env, argv[0]);
+  if (!loop) return NULL;
+
+  napi_deferred deferred;
+  napi_value promise;
+  NAPI_CALL(napi_create_promise(env, &deferred, &promise));
+
+  n_waiter_t* waiter = sl_alloc_t(n_waiter_t);
+  if (!waiter) {
+    napi_throw_error(env, NULL, "failed to allocate waiter");
+    return NULL;
+  }
+
+  *waiter = (n_waiter_t){
+    .kind = N_WAIT_READY,
+    .pid = -1,
+    .fd = fcntl(sb_loop_fd(loop), F_DUPFD_CLOEXEC, 0),
+  };
+  if (waiter->fd < 0) {
+    sl_free(waiter);
+    n_settle(env, deferred, -1, strerror(errno));
+    return promise;
+  }
+
+  if (!n_poller_enqueue(env, argv[0], waiter, deferred)) return NULL;
+  return promise;
+}
+
+/* --- kill(handle, signal) ----------------------------------------------- */
+
+static napi_value n_kill(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  sl_child_t* child = n_get_child(env, argv[0]);
+  if (!child) return NULL;
+  int sig;
+  NAPI_CALL(napi_get_value_int32(env, argv[1], &sig));
+  if (sb_child_kill(child, sig) != 0) {
+    napi_throw_error(env, NULL, sb_child_error(child));
     return NULL;
   }
   napi_value undef;
@@ -405,12 +1871,11 @@ static napi_value n_destroy(napi_env env, napi_callback_info info) {
   size_t argc = 1;
   napi_value argv[1];
   NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
-  n_sb_handle_t* h = NULL;
-  NAPI_CALL(napi_get_value_external(env, argv[0], (void**)&h));
+  void* h = NULL;
+  NAPI_CALL(napi_get_value_external(env, argv[0], &h));
 
-  if (h && h->sb) {
-    sb_destroy(h->sb);
-    h->sb = NULL;
+  if (h) {
+    n_release(h);
   }
 
   napi_value undef;
@@ -418,6 +1883,101 @@ static napi_value n_destroy(napi_env env, napi_callback_info info) {
   return undef;
 }
 
+/* --- capabilities() ---------------------------------------------------- */
+
+static napi_value n_capabilities(napi_env env, napi_callback_info info) {
+  (void)info;
+  const sl_caps_t* caps = sl_capabilities();
+
+  napi_value result;
+  NAPI_CALL(napi_create_object(env, &result));
+
+  napi_value value;
+  NAPI_CALL(napi_get_boolean(env, caps->available, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "available", value));
+  NAPI_CALL(napi_create_int32(env, caps->abi, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "abi", value));
+  NAPI_CALL(napi_create_double(env, (double)caps->fs, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "fs", value));
+  NAPI_CALL(napi_create_double(env, (double)caps->net, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "net", value));
+  NAPI_CALL(napi_get_boolean(env, caps->scoped, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "scoped", value));
+  NAPI_CALL(napi_get_boolean(env, caps->ioctl_dev, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "ioctlDev", value));
+  NAPI_CALL(napi_get_boolean(env, caps->audit, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "audit", value));
+  NAPI_CALL(napi_get_boolean(env, caps->io_uring, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "ioUring", value));
+  return result;
+}
+
+/* --- runtimeInit({ zygote }), runtimeShutdown() ------------------------ */
+
+static napi_value n_runtime_init(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+
+  sb_runtime_opts_t opts = SL_ZERO;
+  napi_value zygote;
+  if (argc >= 1 && napi_get_named_property(env, argv[0], "zygote", &zygote) == napi_ok) {
+    napi_get_value_bool(env, zygote, &opts.zygote);
+  }
+
+  sl_err_t err = sb_runtime_init(&opts);
+  if (err) {
+    napi_throw_error(env, NULL, sl_err_to_string(err));
+    return NULL;
+  }
+  napi_value undef;
+  napi_get_undefined(env, &undef);
+  return undef;
+}
+
+static napi_value n_runtime_shutdown(napi_env env, napi_callback_info info) {
+  (void)info;
+  sb_runtime_shutdown();
+  napi_value undef;
+  napi_get_undefined(env, &undef);
+  return undef;
+}
+
+/* --- stats(handle) ------------------------------------------------------ */
+
+static napi_value n_stats(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  n_sb_handle_t* h = n_get_handle(env, argv[0]);
+  if (!h) return NULL;
+  const sl_stats_t* stats = sb_stats(h->sb);
+
+  napi_value result;
+  NAPI_CALL(napi_create_object(env, &result));
+
+  napi_value value;
+  NAPI_CALL(napi_create_double(env, (double)stats->scope_ns, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "scopeNs", value));
+  NAPI_CALL(napi_create_double(env, (double)stats->ruleset_ns, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "rulesetNs", value));
+  NAPI_CALL(napi_create_double(env, (double)stats->pipes_ns, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "pipesNs", value));
+  NAPI_CALL(napi_create_double(env, (double)stats->fork_ns, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "forkNs", value));
+  NAPI_CALL(napi_create_double(env, (double)stats->setup_ns, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "setupNs", value));
+  NAPI_CALL(napi_create_double(env, (double)stats->restrict_ns, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "restrictNs", value));
+  NAPI_CALL(napi_create_double(env, (double)stats->exec_ns, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "execNs", value));
+  NAPI_CALL(napi_create_double(env, (double)stats->spawn_ns, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "spawnNs", value));
+  NAPI_CALL(napi_create_uint32(env, stats->num_spawns, &value));
+  NAPI_CALL(napi_set_named_property(env, result, "numSpawns", value));
+  return result;
+}
+
 /* --- module init -------------------------------------------------------- */
 
 #define EXPORT_FN(name, fn)  \
@@ -428,10 +1988,39 @@ static napi_value n_destroy(napi_env env, napi_callback_info info) {
   } while (0)
 
 static napi_value sb_napi_init(napi_env env, napi_value exports) {
+  sl_capabilities();
+
+  EXPORT_FN("capabilities", n_capabilities);
+  EXPORT_FN("runtimeInit", n_runtime_init);
+  EXPORT_FN("runtimeShutdown", n_runtime_shutdown);
+  EXPORT_FN("stats", n_stats);
   EXPORT_FN("create", sl_napi_create);
   EXPORT_FN("spawn", n_spawn);
+  EXPORT_FN("spawnChild", n_spawn_child);
+  EXPORT_FN("spawnMany", n_spawn_many);
+  EXPORT_FN("serverCreate", n_server_create);
+  EXPORT_FN("serverSpawn", n_server_spawn);
   EXPORT_FN("pid", n_pid);
+  EXPORT_FN("pidfd", n_pidfd);
   EXPORT_FN("wait", n_wait);
+  EXPORT_FN("tryWait", n_try_wait);
+  EXPORT_FN("waitTimeout", n_wait_timeout);
+  EXPORT_FN("waitAsync", n_wait_async);
+  EXPORT_FN("readAsync", n_read_async);
+  EXPORT_FN("writeAsync", n_write_async);
+  EXPORT_FN("closeStdin", n_close_stdin);
+  EXPORT_FN("stdinUnread", n_stdin_unread);
+  EXPORT_FN("forward", n_forward);
+  EXPORT_FN("forwardWait", n_forward_wait);
+  EXPORT_FN("capture", n_capture);
+  EXPORT_FN("captureWait", n_capture_wait);
+  EXPORT_FN("outputBuffer", n_output_buffer);
+  EXPORT_FN("loopCreate", n_loop_create);
+  EXPORT_FN("loopBackend", n_loop_backend);
+  EXPORT_FN("loopAdd", n_loop_add);
+  EXPORT_FN("loopRemove", n_loop_remove);
+  EXPORT_FN("loopPoll", n_loop_poll);
+  EXPORT_FN("loopWait", n_loop_wait);
   EXPORT_FN("kill", n_kill);
   EXPORT_FN("destroy", n_destroy);
   EXPORT_FN("stdinFd", n_stdin_fd);
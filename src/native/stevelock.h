@@ -114,6 +114,12 @@
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -151,6 +157,10 @@ typedef enum {
   SL_ERROR_INVALID_CONTEXT = 7,
   SL_ERROR_INVALID_COMMAND = 8,
   SL_ERROR_INVALID_SCOPE = 9,
+  SL_ERROR_RESTRICT = 10,
+  SL_ERROR_EXEC = 11,
+  SL_ERROR_INVALID_STDIO = 12,
+  SL_ERROR_FORWARD = 13,
 } sl_err_t;
 
 
@@ -190,11 +200,16 @@ void  sl_free(void* ptr);
 #if defined(SL_LINUX)
 typedef struct {
   s32 abi;
+  s32 ruleset;
+  sl_err_t ruleset_err;
+  s32* read_fds;
+  s32* write_fds;
 } sl_platform_t;
 
 #elif defined(SL_MACOS)
 typedef struct {
   const c8* profile;
+  sl_err_t scope_err;
 } sl_platform_t;
 
 #else
@@ -206,20 +221,96 @@ typedef struct {
   u32 num_dirs;
 } sl_scope_t;
 
+/*
+ * Where each of the child's standard streams goes. The zero value is a pipe
+ * the parent reads or writes, so existing callers keep three pipes. Only
+ * the pipe modes hand the parent a descriptor; a caller's fd (SL_STDIO_FD)
+ * is duplicated for the child and stays owned by the caller. SL_STDIO_MERGE
+ * is only valid for stderr and points it at whatever stdout is.
+ *
+ * SL_STDIO_MEMFD (stdout/stderr) writes into an anonymous in-memory file
+ * instead of a pipe, so the child never stalls on a full pipe and the
+ * parent reads nothing until exit; sb_output_map() then maps it. The
+ * parent's descriptor is that file, not a pipe.
+ */
+typedef enum {
+  SL_STDIO_PIPE = 0,
+  SL_STDIO_INHERIT = 1,
+  SL_STDIO_NULL = 2,
+  SL_STDIO_FD = 3,
+  SL_STDIO_MERGE = 4,
+  SL_STDIO_MEMFD = 5,
+} sl_stdio_mode_t;
+
+typedef struct {
+  sl_stdio_mode_t mode;
+  s32 fd;
+} sl_stdio_stream_t;
+
+typedef struct {
+  sl_stdio_stream_t in;
+  sl_stdio_stream_t out;
+  sl_stdio_stream_t err;
+} sl_stdio_t;
+
+/* Moves one of a child's output pipes to another fd; see sb_forward(). */
+typedef struct sl_forward sl_forward_t;
+
+/* Multiplexes many children's output and exits; see sb_loop_create(). */
+typedef struct sl_loop sl_loop_t;
+
 typedef struct {
   s32 pid;
+  s32 pidfd;
   s32 stdin_fd;
   s32 stdout_fd;
   s32 stderr_fd;
   s32 exited;
-  s32 destroyed;
   s32 exit_code;
+  sl_forward_t* forward[2];
+  sl_loop_t* loop;
+  u32 loop_slot;
+  char error[256];
+} sl_child_t;
+
+/*
+ * Where the time goes, in nanoseconds. The create-time phases are set once
+ * by sb_create(); the rest describe the most recent spawn from the context.
+ * Child-side phases are timestamped in the child and handed back before
+ * exec (through shared memory on Linux, a CLOEXEC pipe on macOS).
+ */
+typedef struct {
+  u64 scope_ns;
+  u64 ruleset_ns;
+  u64 pipes_ns;
+  u64 fork_ns;
+  u64 setup_ns;
+  u64 restrict_ns;
+  u64 exec_ns;
+  u64 spawn_ns;
+  u32 num_spawns;
+} sl_stats_t;
+
+/*
+ * A context is a compiled policy. Any number of children can be launched from
+ * it with sb_spawn_child(); each gets its own handle and outlives the context
+ * if need be. The one-shot sb_spawn() API drives the embedded `child`.
+ */
+typedef struct {
+  sl_child_t child;
+  s32 destroyed;
 
   sl_scope_t read;
   sl_scope_t write;
   u32 network;
+  sl_stdio_t stdio;
+  u64 pipe_size;
+  u32 pipe_flags;
+  s32* inherit_fds;
+  u32 num_inherit_fds;
   char error[256];
 
+  sl_stats_t stats;
   sl_platform_t platform;
 } sl_ctx_t;
 
@@ -227,29 +318,268 @@ typedef struct {
 /////////
 // API //
 /////////
+/*
+ * What the running kernel can enforce, probed once per process. On Linux the
+ * masks are the Landlock access rights this build knows about and the kernel
+ * supports; on macOS only `available` is meaningful.
+ */
+typedef struct {
+  bool available;
+  s32 abi;
+  u64 fs;
+  u64 net;
+  bool scoped;
+  bool ioctl_dev;
+  bool audit;
+  bool pidfd;
+  bool io_uring;
+} sl_caps_t;
+
+/*
+ * A zygote is a helper process forked by sb_runtime_init() that spawns
+ * children on our behalf. They are its siblings (CLONE_PARENT), so they
+ * are still ours to wait on and kill. `fd` is our end of the socket it
+ * listens on; requests are serialized by `lock`.
+ */
+typedef struct {
+  s32 fd;
+  pid_t pid;
+  pthread_mutex_t lock;
+} sl_zygote_t;
+
 typedef struct {
   sl_allocator_t gpa;
+  sl_caps_t caps;
+  sl_zygote_t zygote;
 } sl_runtime_t;
 extern sl_runtime_t sl_rt;
 
+const sl_caps_t* sl_capabilities(void);
+
+/*
+ * `zygote` (Linux) forks the zygote now and routes every later spawn through
+ * it. Forking a big multithreaded host costs page tables and risks whatever
+ * its other threads hold; the zygote is a copy of this process as it is at
+ * the time of the call, so make it early, before the heap grows.
+ */
+typedef struct {
+  bool zygote;
+} sb_runtime_opts_t;
+
+sl_err_t sb_runtime_init(const sb_runtime_opts_t* opts);
+void sb_runtime_shutdown(void);
+
+/*
+ * A fork server (Linux) is a process that has applied a context's policy to
+ * itself once and then forks and execs children on request, so each spawn
+ * skips building and applying the ruleset. Its children are ours, just like
+ * sb_spawn_child()'s, and use the context's stdio, pipe and inherit options;
+ * errors are reported on the context, which must outlive the server.
+ */
+typedef struct sl_server sl_server_t;
+
+/*
+ * sb_spawn_fn() runs a callback in place of a program: the child is forked,
+ * gets the context's stdio, fds and policy exactly as sb_spawn()'s would, and
+ * then _exits with what `fn(arg)` returns, skipping exec and the dynamic
+ * linker. It is a copy of the host, so in a multithreaded host only what is
+ * safe after fork() is safe in `fn`; the zygote is never used.
+ */
+typedef s32 (*sl_spawn_fn_t)(void* arg);
+
+/*
+ * sb_opts_t.pipe_flags. SL_PIPE_NONBLOCK makes the parent's end of every
+ * SL_STDIO_PIPE stream O_NONBLOCK, for callers driving them from an event
+ * loop; the child's end always blocks. A stream handed to sb_forward() or
+ * sb_capture() blocks again, since its thread is the only reader left.
+ */
+#define SL_PIPE_NONBLOCK (1u << 0)
+
+/*
+ * `pipe_size`, when set, is the capacity each SL_STDIO_PIPE pipe is raised
+ * to (F_SETPIPE_SZ, so Linux only, rounded up to a power-of-two number of
+ * pages and capped by /proc/sys/fs/pipe-max-size). A child writing lots of
+ * output stalls less on a bigger pipe.
+ *
+ * Children start with stdin, stdout and stderr and nothing else: every
+ * other descriptor is closed before the sandbox is applied, close-on-exec
+ * or not, so a child can't reach host sockets or files through a leaked
+ * fd. `inherit_fds` are passed through under the same numbers; a spawn
+ * through the zygote or a fork server carries at most 64 of them, so with
+ * the zygote running sb_create() refuses more.
+ */
 typedef struct {
   sl_scope_t read;
   sl_scope_t write;
   u32 network;
+  sl_stdio_t stdio;
+  u64 pipe_size;
+  u32 pipe_flags;
+  const s32* inherit_fds;
+  u32 num_inherit_fds;
 } sb_opts_t;
 
 typedef const c8* const* sl_env_t;
 
+/* Returned by the non-blocking waits while the child is still running. */
+#define SL_CHILD_RUNNING (-2)
+
+typedef struct {
+  const c8* cmd;
+  const c8* const* args;
+  u32 num_args;
+  sl_env_t env;
+  const sl_stdio_t* stdio;
+} sb_spawn_spec_t;
+
+typedef enum {
+  SL_STDOUT = 1,
+  SL_STDERR = 2,
+} sl_stream_t;
+
+/* Also keep everything forwarded in memory, handed back by sb_forward_wait(). */
+#define SL_FORWARD_TEE (1u << 0)
+
+typedef struct {
+  u64 bytes;
+  u8* copy;
+  u64 copy_len;
+} sl_forward_result_t;
+
+/* Bounded capture: keep the first `head` and last `tail` bytes; 0 quota is none. */
+typedef struct {
+  u64 head;
+  u64 tail;
+  u64 quota;
+} sl_capture_opts_t;
+
+typedef struct {
+  u8* head;
+  u64 head_len;
+  u8* tail;
+  u64 tail_len;
+  u64 total;
+  bool over_quota;
+} sl_capture_t;
+
+/*
+ * sb_write_stdin() flags. SL_WRITE_GIFT (Linux) hands the pages to the pipe
+ * with vmsplice(2) instead of copying them: `buf` must then stay unchanged
+ * until the child has read it, though unmapping it is fine. Elsewhere it
+ * is an ordinary write. SL_WRITE_NONBLOCK returns once the pipe is full
+ * instead of waiting for the child to make room; the parent's end keeps its
+ * flags either way.
+ */
+#define SL_WRITE_GIFT (1u << 0)
+#define SL_WRITE_NONBLOCK (1u << 1)
+
+/* A child's SL_STDIO_MEMFD output, mapped copy-on-write; see sb_output_map(). */
+typedef struct {
+  u8* data;
+  u64 len;
+} sl_output_t;
+
+/*
+ * One readiness set (epoll on Linux, kqueue on macOS) over the output pipes
+ * and exits of any number of children, so a poll costs O(ready) rather than
+ * O(children). Output events point into the loop's buffer and are valid
+ * until the next sb_loop_poll(); a zero-length output event is EOF. A child
+ * is in at most one loop and leaves it when released, or by itself once
+ * both pipes hit EOF and its exit has been reported (that event is marked
+ * `last`). Not thread-safe.
+ *
+ * Where the kernel allows it (sl_caps_t.io_uring) the loop is an io_uring
+ * instead: each pipe has one multishot read into a ring of provided buffers
+ * and each pidfd one poll, so a busy poll is a single io_uring_enter() that
+ * submits the re-arms and reaps the data, with no read(2) per pipe.
+ * SL_LOOP_BACKEND_AUTO falls back to the readiness set when io_uring is
+ * missing, too old, or refused (seccomp, io_uring_disabled).
+ */
+typedef enum {
+  SL_LOOP_BACKEND_AUTO = 0,
+  SL_LOOP_BACKEND_POLL = 1,
+  SL_LOOP_BACKEND_IO_URING = 2,
+} sl_loop_backend_t;
+
+typedef struct {
+  sl_loop_backend_t backend;
+} sb_loop_opts_t;
+
+typedef enum {
+  SL_LOOP_STDOUT = SL_STDOUT,
+  SL_LOOP_STDERR = SL_STDERR,
+  SL_LOOP_EXIT = 3,
+} sl_loop_kind_t;
+
+typedef struct {
+  sl_loop_kind_t kind;
+  sl_child_t* child;
+  void* user;
+  const u8* data;
+  u64 len;
+  s32 exit_code;
+  bool last;
+} sl_loop_event_t;
+
 sl_ctx_t* sb_create(const sb_opts_t* opts);
 sl_err_t  sb_spawn(sl_ctx_t* sb, const c8* cmd, const c8* const* args, u32 num_args, sl_env_t env);
+sl_err_t  sb_spawn_fn(sl_ctx_t* sb, sl_spawn_fn_t fn, void* arg);
 pid_t     sb_pid(const sl_ctx_t* sb);
 int       sb_stdin_fd(const sl_ctx_t* sb);
 int       sb_stdout_fd(const sl_ctx_t* sb);
 int       sb_stderr_fd(const sl_ctx_t* sb);
+int       sb_pidfd(const sl_ctx_t* sb);
 int       sb_wait(sl_ctx_t* sb);
+int       sb_try_wait(sl_ctx_t* sb);
+int       sb_wait_timeout(sl_ctx_t* sb, s32 ms);
 int       sb_kill(sl_ctx_t* sb, int sig);
 void      sb_destroy(sl_ctx_t* sb);
 const c8* sb_error(const sl_ctx_t* sb);
+const sl_stats_t* sb_stats(const sl_ctx_t* sb);
+sl_err_t  sb_forward(sl_ctx_t* sb, sl_stream_t stream, s32 dest_fd, u32 flags);
+sl_err_t  sb_forward_wait(sl_ctx_t* sb, sl_stream_t stream, sl_forward_result_t* out);
+sl_err_t  sb_capture(sl_ctx_t* sb, sl_stream_t stream, const sl_capture_opts_t* opts);
+sl_err_t  sb_capture_wait(sl_ctx_t* sb, sl_stream_t stream, sl_capture_t* out);
+sl_err_t  sb_output_map(sl_ctx_t* sb, sl_stream_t stream, sl_output_t* out);
+void      sb_output_unmap(sl_output_t* output);
+s64       sb_write_stdin(sl_ctx_t* sb, const void* buf, u64 len, u32 flags);
+sl_err_t  sb_close_stdin(sl_ctx_t* sb);
+
+sl_err_t  sb_spawn_child(sl_ctx_t* sb, const c8* cmd, const c8* const* args, u32 num_args, sl_env_t env, sl_child_t** out);
+sl_err_t  sb_spawn_many(sl_ctx_t* sb, const sb_spawn_spec_t* specs, u32 num_specs, sl_child_t** out);
+pid_t     sb_child_pid(const sl_child_t* child);
+int       sb_child_stdin_fd(const sl_child_t* child);
+int       sb_child_stdout_fd(const sl_child_t* child);
+int       sb_child_stderr_fd(const sl_child_t* child);
+int       sb_child_pidfd(const sl_child_t* child);
+int       sb_child_wait(sl_child_t* child);
+int       sb_child_try_wait(sl_child_t* child);
+int       sb_child_wait_timeout(sl_child_t* child, s32 ms);
+int       sb_child_kill(sl_child_t* child, int sig);
+sl_err_t  sb_child_forward(sl_child_t* child, sl_stream_t stream, s32 dest_fd, u32 flags);
+sl_err_t  sb_child_forward_wait(sl_child_t* child, sl_stream_t stream, sl_forward_result_t* out);
+sl_err_t  sb_child_capture(sl_child_t* child, sl_stream_t stream, const sl_capture_opts_t* opts);
+sl_err_t  sb_child_capture_wait(sl_child_t* child, sl_stream_t stream, sl_capture_t* out);
+sl_err_t  sb_child_output_map(sl_child_t* child, sl_stream_t stream, sl_output_t* out);
+s64       sb_child_write_stdin(sl_child_t* child, const void* buf, u64 len, u32 flags);
+sl_err_t  sb_child_close_stdin(sl_child_t* child);
+void      sb_child_destroy(sl_child_t* child);
+const c8* sb_child_error(const sl_child_t* child);
+
+sl_server_t* sb_server_create(sl_ctx_t* sb);
+sl_err_t  sb_server_spawn(sl_server_t* server, const c8* cmd, const c8* const* args, u32 num_args, sl_env_t env, sl_child_t** out);
+void      sb_server_destroy(sl_server_t* server);
+
+sl_loop_t* sb_loop_create(const sb_loop_opts_t* opts);
+void      sb_loop_destroy(sl_loop_t* loop);
+int       sb_loop_fd(const sl_loop_t* loop);
+sl_loop_backend_t sb_loop_backend(const sl_loop_t* loop);
+sl_err_t  sb_loop_add(sl_loop_t* loop, sl_ctx_t* sb, void* user);
+sl_err_t  sb_loop_add_child(sl_loop_t* loop, sl_child_t* child, void* user);
+void      sb_loop_remove(sl_loop_t* loop, sl_ctx_t* sb);
+void      sb_loop_remove_child(sl_loop_t* loop, sl_child_t* child);
+int       sb_loop_poll(sl_loop_t* loop, sl_loop_event_t* events, u32 max, s32 timeout_ms);
+const c8* sb_loop_error(const sl_loop_t* loop);
 
 #ifdef STEVELOCK_IMPLEMENTATION
 
@@ -259,6 +589,12 @@ sl_runtime_t sl_rt = {
       .on_alloc = sl_malloc_allocator,
       .user_data = SL_NULLPTR,
     },
+  .zygote =
+    {
+      .fd = -1,
+      .pid = -1,
+      .lock = PTHREAD_MUTEX_INITIALIZER,
+    },
 };
 ////////////
 // STRING //
@@ -281,19 +617,180 @@ static c8* sl_cstr_copy(const c8* src);
 #define SL_CHILD_PRE_EXEC_FAILURE 126
 #define SL_CHILD_POST_EXEC_FAILURE 127
 #define SL_NULL_PIPE {-1, -1}
-#define SL_NULL_PIPES {SL_NULL_PIPE, SL_NULL_PIPE, SL_NULL_PIPE}
+#define SL_NULL_PIPES {SL_NULL_PIPE, SL_NULL_PIPE, SL_NULL_PIPE, false}
 
+/* Child ends are in[0], out[1], err[1]; -1 leaves the inherited fd alone. */
 typedef struct {
   s32 in[2];
   s32 out[2];
   s32 err[2];
+  bool merge_err;
 } sl_pipes_t;
 
+typedef enum {
+  SL_SPAWN_PHASE_NONE = 0,
+  SL_SPAWN_PHASE_STDIO = 1,
+  SL_SPAWN_PHASE_NO_NEW_PRIVS = 2,
+  SL_SPAWN_PHASE_RESTRICT = 3,
+  SL_SPAWN_PHASE_EXEC = 4,
+  SL_SPAWN_PHASE_FDS = 5,
+} sl_spawn_phase_t;
+
+/*
+ * What the child tells the parent on its way to exec: CLOCK_MONOTONIC
+ * stamps, and, if it gave up, the phase it died in and errno. It is filled
+ * in without allocating or touching stdio.
+ */
+typedef struct {
+  u64 started;
+  u64 stdio;
+  u64 restricted;
+  u64 exec;
+  s32 phase;
+  s32 err;
+} sl_spawn_report_t;
+
+/*
+ * A forwarder owns the parent's end of the child's pipe and a dup of the
+ * destination, and runs on its own small thread until EOF or until the
+ * child is released. `copy` is the tee pipe on Linux; `keep` is what
+ * SL_FORWARD_TEE accumulates. A capture is a forwarder without a
+ * destination: `head` and the `tail` ring are all it keeps.
+ */
+#define SL_FORWARD_CHUNK (64 * 1024)
+#define SL_FORWARD_STACK (64 * 1024)
+
+/* sb_write_stdin() grows the stdin pipe towards a large payload, up to this. */
+#define SL_STDIN_PIPE_SIZE (1024 * 1024)
+
+struct sl_forward {
+  pthread_t thread;
+  s32 src;
+  s32 dest;
+  s32 wake[2];
+  s32 copy[2];
+  u32 flags;
+  bool splice;
+  u64 bytes;
+  u8* keep;
+  u64 keep_len;
+  u64 keep_cap;
+  u8* scratch;
+  s32 pidfd;
+  pid_t pid;
+  bool reaped;
+  u64 quota;
+  bool over_quota;
+  u8* head;
+  u64 head_cap;
+  u64 head_len;
+  u8* tail;
+  u64 tail_cap;
+  u64 tail_len;
+  u64 tail_pos;
+  const c8* op;
+  s32 err;
+};
+
+/*
+ * Loop registrations live in a slot table; what the kernel hands back for a
+ * ready descriptor is a token naming the slot, its generation (so a reused
+ * slot can't be mistaken for the old one) and which of the three watches
+ * fired.
+ */
+#define SL_LOOP_READ (64 * 1024)
+#define SL_LOOP_BUFFER (1024 * 1024)
+#define SL_LOOP_MAX_READY 256
+#define SL_LOOP_EXIT_POLL_MS 10
+#define SL_LOOP_GEN_MASK 0x3fffffffu
+
+typedef enum {
+  SL_LOOP_WATCH_STDOUT = 0,
+  SL_LOOP_WATCH_STDERR = 1,
+  SL_LOOP_WATCH_EXIT = 2,
+} sl_loop_watch_t;
+
+typedef struct {
+  sl_child_t* child;
+  void* user;
+  u32 gen;
+  bool live;
+  bool watched[3];
+  bool poll_exit;
+} sl_loop_entry_t;
+
+/* Linux only: the io_uring backend's rings; see sl_uring_open(). */
+typedef struct sl_uring sl_uring_t;
+
+struct sl_loop {
+  s32 fd;
+  sl_uring_t* uring;
+  sl_loop_entry_t* entries;
+  u32 num_entries;
+  u32 num_poll_exit;
+  u8* buffer;
+  c8 error[256];
+};
+
+/*
+ * What a backend reports per token. A readiness backend only says the
+ * descriptor is ready (`done` false) and sb_loop_poll() reads it; io_uring
+ * has already done the work, so `res` is the read's result (or the poll
+ * mask, for exits) and `data` the buffer it landed in.
+ */
+typedef struct {
+  u64 token;
+  const u8* data;
+  s64 res;
+  bool done;
+} sl_loop_ready_t;
+
 static void sl_child_fail(s32 exit_code);
-static bool sl_is_child(s32 pid);
 static bool sl_is_parent(s32 pid);
 static void sl_pipe_try_close(s32 pipes[2]);
 static void sl_pipes_try_close(sl_pipes_t* pipes);
+static s32 sl_pipes_wire(const sl_pipes_t* pipes);
+static s32 sl_fds_sweep(const s32* inherit, u32 num_inherit, s32 keep);
+static s32* sl_fds_copy(const s32* fds, u32 n);
+static void sl_child_init(sl_child_t* child);
+static void sl_child_release(sl_child_t* child);
+static void sl_child_adopt(sl_child_t* child, pid_t pid, sl_pipes_t* pipes);
+static s32 sl_child_reap(sl_child_t* child, int status);
+static sl_err_t sl_spawn(sl_ctx_t* sb, sl_child_t* child, sl_zygote_t* server, const c8* cmd, const c8* const* args, u32 num_args, sl_env_t env);
+static sl_err_t sl_platform_check(const sl_ctx_t* sb);
+static sl_err_t sl_platform_spawn(sl_ctx_t* sb, sl_child_t* child, sl_zygote_t* server, sl_pipes_t* pipes, const c8* const* argv, sl_env_t env);
+static sl_err_t sl_platform_server_start(sl_ctx_t* sb, sl_zygote_t* server);
+static sl_spawn_phase_t sl_platform_restrict_self(const sl_ctx_t* sb);
+static s32 sl_platform_pidfd_open(pid_t pid);
+static s32 sl_platform_signal(s32 pidfd, pid_t pid, s32 sig);
+static void sl_report_read(s32 fd, sl_spawn_report_t* report);
+static void sl_report_write(s32 fd, const sl_spawn_report_t* report);
+static void sl_report_abort(s32 fd, sl_spawn_report_t* report, sl_spawn_phase_t phase, s32 exit_code);
+static void sl_probe_capabilities(sl_caps_t* caps);
+static u64 sl_now_ns(void);
+static void sl_stats_record(sl_stats_t* stats, const sl_spawn_report_t* report, u64 fork_start, u64 exec_seen);
+static sl_err_t sl_spawn_check_report(sl_ctx_t* sb, pid_t pid, sl_pipes_t* pipes, const sl_spawn_report_t* report, const c8* cmd);
+static bool sl_platform_forward(sl_forward_t* fw);
+static s32 sl_platform_memfd(const c8* name);
+static s32 sl_platform_output_map(s32 fd, sl_output_t* out);
+static s32 sl_platform_pipe(s32 fds[2]);
+static s32 sl_platform_close_range(u32 from, u32 to);
+static sl_err_t sl_platform_zygote_start(sl_zygote_t* zygote);
+static ssize_t sl_platform_write_stdin(s32 fd, const u8* buf, u64 len, u32 flags);
+static ssize_t sl_write_nowait(s32 fd, const u8* buf, u64 len);
+static void sl_platform_pipe_grow(s32 fd, u64 size);
+static bool sl_platform_loop_open(sl_loop_t* loop, sl_loop_backend_t backend);
+static void sl_platform_loop_close(sl_loop_t* loop);
+static bool sl_platform_loop_watch(sl_loop_t* loop, sl_loop_watch_t watch, const sl_child_t* child, u64 token);
+static void sl_platform_loop_unwatch(sl_loop_t* loop, sl_loop_watch_t watch, const sl_child_t* child, u64 token);
+static bool sl_platform_loop_commit(sl_loop_t* loop);
+static s32 sl_platform_loop_wait(sl_loop_t* loop, sl_loop_ready_t* ready, u32 max, s32 timeout_ms);
+static s32 sl_loop_child_fd(const sl_child_t* child, sl_loop_watch_t watch);
+static bool sl_forward_fail(sl_forward_t* fw, const c8* op);
+static bool sl_forward_wait_dest(sl_forward_t* fw);
+static bool sl_forward_reserve(sl_forward_t* fw, u64 len);
+static bool sl_forward_copy(sl_forward_t* fw, u64 max, bool keep);
+static void sl_forward_stop(sl_forward_t* fw);
 
 const c8* sl_err_to_string(sl_err_t err) {
   switch (err) {
@@ -317,6 +814,14 @@ const c8* sl_err_to_string(sl_err_t err) {
     return "SL_ERROR_INVALID_COMMAND";
   case SL_ERROR_INVALID_SCOPE:
     return "SL_ERROR_INVALID_SCOPE";
+  case SL_ERROR_RESTRICT:
+    return "SL_ERROR_RESTRICT";
+  case SL_ERROR_EXEC:
+    return "SL_ERROR_EXEC";
+  case SL_ERROR_INVALID_STDIO:
+    return "SL_ERROR_INVALID_STDIO";
+  case SL_ERROR_FORWARD:
+    return "SL_ERROR_FORWARD";
   }
   return "SL_ERROR_UNKNOWN";
 }
@@ -386,74 +891,131 @@ static c8* sl_cstr_copy(const c8* src) {
   return dst;
 }
 
-static sl_err_t sl_validate_scope(const sl_scope_t* scope, const c8* kind, c8* err, u64 err_len) {
-  if (!scope || !scope->num_dirs) {
-    return SL_OK;
-  }
-
-  for (u32 i = 0; i < scope->num_dirs; i++) {
-    const c8* path = scope->dirs[i];
-    if (!path || !path[0]) {
-      snprintf(err, err_len, "%s scope[%u] is empty", kind, i);
-      return SL_ERROR_INVALID_SCOPE;
-    }
+void sl_child_fail(s32 exit_code) { _exit(exit_code); }
 
-    struct stat st;
-    if (stat(path, &st) != 0) {
-      snprintf(err, err_len, "%s scope[%u] stat(%s): %s", kind, i, path, strerror(errno));
-      return SL_ERROR_INVALID_SCOPE;
-    }
+bool sl_is_parent(s32 pid) { return pid > 0; }
 
-    if (!S_ISDIR(st.st_mode)) {
-      snprintf(err, err_len, "%s scope[%u] is not a directory: %s", kind, i, path);
-      return SL_ERROR_INVALID_SCOPE;
+void sl_pipe_try_close(s32 pipes[2]) {
+  sp_for(it, 2) {
+    if (pipes[it] >= 0) {
+      close(pipes[it]);
     }
   }
+}
 
-  return SL_OK;
+void sl_pipes_try_close(sl_pipes_t* pipes) {
+  sl_pipe_try_close(pipes->in);
+  sl_pipe_try_close(pipes->out);
+  sl_pipe_try_close(pipes->err);
 }
 
-static sl_err_t sl_validate_ctx_scopes(sl_ctx_t* sb) {
-  if (!sb) {
-    return SL_ERROR_INVALID_CONTEXT;
-  }
+/*
+ * Async-signal-safe; runs in the child between fork and exec. dup2 clears
+ * close-on-exec on what it wires; an inherited stream is the parent's own
+ * descriptor, which may carry the flag (Node sets it on its stdio), so it is
+ * cleared by hand. A closed one stays closed.
+ */
+s32 sl_pipes_wire(const sl_pipes_t* pipes) {
+  if (pipes->in[0] < 0) fcntl(STDIN_FILENO, F_SETFD, 0);
+  if (pipes->out[1] < 0) fcntl(STDOUT_FILENO, F_SETFD, 0);
+  if (pipes->err[1] < 0 && !pipes->merge_err) fcntl(STDERR_FILENO, F_SETFD, 0);
+
+  if (pipes->in[0] >= 0 && dup2(pipes->in[0], STDIN_FILENO) < 0) return -1;
+  if (pipes->out[1] >= 0 && dup2(pipes->out[1], STDOUT_FILENO) < 0) return -1;
+  if (pipes->merge_err) return dup2(STDOUT_FILENO, STDERR_FILENO) < 0 ? -1 : 0;
+  if (pipes->err[1] >= 0 && dup2(pipes->err[1], STDERR_FILENO) < 0) return -1;
+  return 0;
+}
 
-  sp_try(sl_validate_scope(&sb->read, "read", sb->error, sizeof(sb->error)));
-  sp_try(sl_validate_scope(&sb->write, "write", sb->error, sizeof(sb->error)));
-  return SL_OK;
+/*
+ * A fork()ed child (every macOS spawn, sb_spawn_fn) doesn't share our
+ * memory, so its report comes back over a CLOEXEC pipe: once just before
+ * exec, and again if exec (or anything earlier) fails. Reading to EOF makes
+ * this return only once the child has exec'd or died, the same as the vfork
+ * path on Linux; the last complete report wins.
+ */
+void sl_report_read(s32 fd, sl_spawn_report_t* report) {
+  sl_spawn_report_t next;
+  u8* out = (u8*)&next;
+  u64 got = 0;
+  while (true) {
+    ssize_t n = read(fd, out + got, sizeof(next) - got);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+
+    got += (u64)n;
+    if (got == sizeof(next)) {
+      *report = next;
+      got = 0;
+    }
+  }
 }
 
-void sl_child_fail(s32 exit_code) { _exit(exit_code); }
+void sl_report_write(s32 fd, const sl_spawn_report_t* report) {
+  ssize_t n = write(fd, report, sizeof(*report));
+  (void)n;
+}
 
-bool sl_is_child(s32 pid) { return pid == 0; }
+void sl_report_abort(s32 fd, sl_spawn_report_t* report, sl_spawn_phase_t phase, s32 exit_code) {
+  report->err = errno;
+  report->phase = phase;
+  sl_report_write(fd, report);
+  _exit(exit_code);
+}
 
-bool sl_is_parent(s32 pid) { return pid > 0; }
+/*
+ * Closes every descriptor above stderr except `inherit`, which loses
+ * close-on-exec so it survives the exec, and `keep` (-1 for none), which is
+ * ours and goes away at exec by itself. Async-signal-safe; runs in the child
+ * between fork and exec.
+ */
+s32 sl_fds_sweep(const s32* inherit, u32 num_inherit, s32 keep) {
+  sl_for(it, num_inherit) {
+    if (inherit[it] > STDERR_FILENO && fcntl(inherit[it], F_SETFD, 0)) return -1;
+  }
 
-void sl_pipe_try_close(s32 pipes[2]) {
-  sp_for(it, 2) {
-    if (pipes[it] >= 0) {
-      close(pipes[it]);
+  u32 from = STDERR_FILENO + 1;
+  for (;;) {
+    u32 next = ~0U;
+    sl_for(it, num_inherit) {
+      if (inherit[it] >= (s32)from && (u32)inherit[it] < next) next = (u32)inherit[it];
     }
+    if (keep >= (s32)from && (u32)keep < next) next = (u32)keep;
+
+    if (next > from && sl_platform_close_range(from, next == ~0U ? ~0U : next - 1)) return -1;
+    if (next == ~0U) return 0;
+    from = next + 1;
   }
 }
 
-void sl_pipes_try_close(sl_pipes_t* pipes) {
-  sl_pipe_try_close(pipes->in);
-  sl_pipe_try_close(pipes->out);
-  sl_pipe_try_close(pipes->err);
+s32* sl_fds_copy(const s32* fds, u32 n) {
+  if (!n) return SL_NULLPTR;
+
+  s32* copy = sl_alloc_n(s32, n);
+  if (!copy) return SL_NULLPTR;
+
+  memcpy(copy, fds, n * sizeof(s32));
+  return copy;
 }
 
 #if defined(SL_LINUX)
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <linux/io_uring.h>
 #include <linux/landlock.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
 #include <sys/prctl.h>
+#include <sys/socket.h>
 #include <sys/syscall.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -496,14 +1058,39 @@ static inline int landlock_restrict_self(int ruleset_fd, __u32 flags) {
 
 #define ACCESS_FS_ALL (ACCESS_FS_ROUGHLY_READ | ACCESS_FS_ROUGHLY_WRITE)
 
-static u64 get_fs_mask() {
+static bool sl_uring_probe(void);
+
+static void sl_probe_capabilities(sl_caps_t* caps) {
   s32 abi = landlock_create_ruleset(NULL, 0, LANDLOCK_CREATE_RULESET_VERSION);
+  *caps = (sl_caps_t){
+    .available = abi >= 1,
+    .abi = abi,
+  };
+
+  /* pidfds and io_uring are independent of Landlock, so they are probed
+   * before the early return. */
+#if defined(SYS_pidfd_open) && defined(CLONE_PIDFD)
+  s32 pidfd = (s32)syscall(SYS_pidfd_open, getpid(), 0);
+  if (pidfd >= 0) {
+    caps->pidfd = true;
+    close(pidfd);
+  }
+#endif
 
-  u64 mask = ACCESS_FS_ALL;
-  if (abi < 2) mask &= ~LANDLOCK_ACCESS_FS_REFER;
-  if (abi < 3) mask &= ~LANDLOCK_ACCESS_FS_TRUNCATE;
+  caps->io_uring = sl_uring_probe();
+  if (abi < 1) return;
 
-  return mask;
+  caps->fs = ACCESS_FS_ALL;
+  if (abi < 2) caps->fs &= ~LANDLOCK_ACCESS_FS_REFER;
+  if (abi < 3) caps->fs &= ~LANDLOCK_ACCESS_FS_TRUNCATE;
+
+#if SL_HAS_LANDLOCK_NET
+  if (abi >= 4) caps->net = LANDLOCK_ACCESS_NET_BIND_TCP | LANDLOCK_ACCESS_NET_CONNECT_TCP;
+#endif
+
+  caps->ioctl_dev = abi >= 5;
+  caps->scoped = abi >= 6;
+  caps->audit = abi >= 7;
 }
 
 /* --- sandbox struct ----------------------------------------------------- */
@@ -511,48 +1098,98 @@ static u64 get_fs_mask() {
 /* --- helpers ------------------------------------------------------------ */
 
 /*
- * Open a path with O_PATH and add a LANDLOCK_RULE_PATH_BENEATH rule
- * granting `access` under that path. Returns 0 on success, -1 on error.
+ * Resolve every directory in `scope` to an O_PATH descriptor, once. The
+ * descriptors are what gets validated (fstat) and what the rules are built
+ * from, so a rename between the two cannot swap the directory underneath us.
  */
-static int add_path_rule(int ruleset_fd, const char* path, __u64 access, char* errbuf, size_t errbuf_sz) {
-  int fd = open(path, O_PATH | O_CLOEXEC);
-  if (fd < 0) {
-    snprintf(errbuf, errbuf_sz, "open(%s, O_PATH): %s", path, strerror(errno));
-    return -1;
+static sl_err_t sl_open_scope(const sl_scope_t* scope, s32* fds, const c8* kind, c8* err, u64 err_len) {
+  sl_for(i, scope->num_dirs) {
+    const c8* path = scope->dirs[i];
+    if (!path || !path[0]) {
+      snprintf(err, err_len, "%s scope[%u] is empty", kind, i);
+      return SL_ERROR_INVALID_SCOPE;
+    }
+
+    fds[i] = open(path, O_PATH | O_CLOEXEC);
+    if (fds[i] < 0) {
+      snprintf(err, err_len, "%s scope[%u] open(%s): %s", kind, i, path, strerror(errno));
+      return SL_ERROR_INVALID_SCOPE;
+    }
+
+    struct stat st;
+    if (fstat(fds[i], &st) != 0) {
+      snprintf(err, err_len, "%s scope[%u] fstat(%s): %s", kind, i, path, strerror(errno));
+      return SL_ERROR_INVALID_SCOPE;
+    }
+
+    if (!S_ISDIR(st.st_mode)) {
+      snprintf(err, err_len, "%s scope[%u] is not a directory: %s", kind, i, path);
+      return SL_ERROR_INVALID_SCOPE;
+    }
+  }
+
+  return SL_OK;
+}
+
+static s32* sl_alloc_fds(u32 n) {
+  s32* fds = sl_alloc_n(s32, n);
+  if (!fds) return SL_NULLPTR;
+
+  sl_for(it, n) { fds[it] = -1; }
+  return fds;
+}
+
+static void sl_close_fds(s32* fds, u32 n) {
+  if (!fds) return;
+
+  sl_for(it, n) {
+    if (fds[it] >= 0) close(fds[it]);
   }
+  sl_free(fds);
+}
 
+/*
+ * Add a LANDLOCK_RULE_PATH_BENEATH rule granting `access` under the directory
+ * `fd` refers to. `path` is only used for the error message.
+ */
+static sl_err_t add_fd_rule(s32 ruleset_fd, s32 fd, const char* path, __u64 access, sl_ctx_t* sb) {
   struct landlock_path_beneath_attr pb = {
     .allowed_access = access,
     .parent_fd = fd,
   };
 
-  int ret = landlock_add_rule(ruleset_fd, LANDLOCK_RULE_PATH_BENEATH, &pb, 0);
-  int saved = errno;
-  close(fd);
-
-  if (ret < 0) {
-    snprintf(errbuf, errbuf_sz, "landlock_add_rule(%s): %s", path, strerror(saved));
-    return -1;
+  if (landlock_add_rule(ruleset_fd, LANDLOCK_RULE_PATH_BENEATH, &pb, 0) < 0) {
+    snprintf(sb->error, sizeof(sb->error), "landlock_add_rule(%s): %s", path, strerror(errno));
+    close(ruleset_fd);
+    return SL_ERROR_RULESET_ADD;
   }
-  return 0;
+  return SL_OK;
 }
 
-static sl_err_t add_path_rule_safe(s32 ruleset_fd, const char* path, __u64 access, sl_ctx_t* sb) {
-  if (add_path_rule(ruleset_fd, path, access, (char*)sb->error, sizeof(sb->error)) < 0) {
+/* Same as add_fd_rule, for the fixed system paths we don't keep open. */
+static sl_err_t add_path_rule(s32 ruleset_fd, const char* path, __u64 access, sl_ctx_t* sb) {
+  s32 fd = open(path, O_PATH | O_CLOEXEC);
+  if (fd < 0) {
+    snprintf(sb->error, sizeof(sb->error), "open(%s, O_PATH): %s", path, strerror(errno));
     close(ruleset_fd);
     return SL_ERROR_RULESET_ADD;
   }
-  return SL_OK;
+
+  sl_err_t err = add_fd_rule(ruleset_fd, fd, path, access, sb);
+  close(fd);
+  return err;
 }
 
 /*
  * Build a landlock ruleset fd configured per `sb`.
- * Returns SL_OK and writes the fd to out_fd.
+ * Returns SL_OK and writes the fd to out_fd. Called once from sb_create; every
+ * spawn from the context restricts itself with the same fd.
  */
 static sl_err_t build_ruleset(sl_ctx_t* sb, s32* out_fd) {
   *out_fd = -1;
 
-  u64 mask = get_fs_mask();
+  const sl_caps_t* caps = sl_capabilities();
+  u64 mask = caps->fs;
 
   struct landlock_ruleset_attr attr = {
     .handled_access_fs = mask,
@@ -563,10 +1200,9 @@ static sl_err_t build_ruleset(sl_ctx_t* sb, s32* out_fd) {
 
   /* If network is denied, handle TCP bind+connect so they're blocked
    * unless we add explicit allow rules (which we won't). */
-  int abi = landlock_create_ruleset(NULL, 0, LANDLOCK_CREATE_RULESET_VERSION);
 #if SL_HAS_LANDLOCK_NET
-  if (!sb->network && abi >= 4) {
-    attr.handled_access_net = LANDLOCK_ACCESS_NET_BIND_TCP | LANDLOCK_ACCESS_NET_CONNECT_TCP;
+  if (!sb->network) {
+    attr.handled_access_net = caps->net;
   }
 #endif
 
@@ -578,24 +1214,24 @@ static sl_err_t build_ruleset(sl_ctx_t* sb, s32* out_fd) {
 
   /* Allow read+execute on / (the whole filesystem) */
   __u64 read_access = ACCESS_FS_ROUGHLY_READ & mask;
-  sp_try(add_path_rule_safe(ruleset_fd, "/", read_access, sb));
+  sp_try(add_path_rule(ruleset_fd, "/", read_access, sb));
 
   /* Allow full access (read+write) to each writable directory */
   __u64 full_access = mask;
   for (u32 i = 0; i < sb->write.num_dirs; i++) {
-    sp_try(add_path_rule_safe(ruleset_fd, sb->write.dirs[i], full_access, sb));
+    sp_try(add_fd_rule(ruleset_fd, sb->platform.write_fds[i], sb->write.dirs[i], full_access, sb));
   }
 
   /* Allow writes to /dev (for /dev/null, /dev/tty, etc.) */
-  sp_try(add_path_rule_safe(ruleset_fd, "/dev", full_access, sb));
+  sp_try(add_path_rule(ruleset_fd, "/dev", full_access, sb));
 
   /* Additional readable paths */
   for (u32 i = 0; i < sb->read.num_dirs; i++) {
-    sp_try(add_path_rule_safe(ruleset_fd, sb->read.dirs[i], read_access, sb));
+    sp_try(add_fd_rule(ruleset_fd, sb->platform.read_fds[i], sb->read.dirs[i], read_access, sb));
   }
 
   /* If network allowed, add rules for all TCP ports */
-  if (sb->network && abi >= 4) {
+  if (sb->network && caps->net) {
     /* Not handling net means net is unrestricted - already the case
      * since we didn't set handled_access_net. Nothing to do. */
   }
@@ -604,39 +1240,549 @@ static sl_err_t build_ruleset(sl_ctx_t* sb, s32* out_fd) {
   return SL_OK;
 }
 
-/* --- public API --------------------------------------------------------- */
-
-sl_ctx_t* sb_create(const sb_opts_t* opts) {
-  if (!opts) return SL_NULLPTR;
-  if (opts->write.num_dirs > 0 && !opts->write.dirs) return SL_NULLPTR;
-  if (opts->read.num_dirs > 0 && !opts->read.dirs) return SL_NULLPTR;
+/* --- spawn trampoline --------------------------------------------------- */
 
-  s32 abi = landlock_create_ruleset(NULL, 0, LANDLOCK_CREATE_RULESET_VERSION);
-  if (abi < 0) return SL_NULLPTR;
+/*
+ * The child is started with CLONE_VM|CLONE_VFORK on a private stack, the same
+ * way posix_spawn does it. Nothing is copied, so spawn cost does not depend on
+ * the size of the host's heap; the parent thread is suspended until the child
+ * execs or exits. Because the child shares our memory it must stick to raw
+ * syscalls: no allocation, no stdio, and no signal handlers of ours may run.
+ */
+#define SL_SPAWN_STACK_SIZE (256 * 1024)
 
-  sl_ctx_t* sl = sl_alloc(sizeof(sl_ctx_t));
-  if (!sl) return SL_NULLPTR;
+typedef struct {
+  sl_pipes_t pipes;
+  s32 ruleset;
+  const s32* inherit_fds;
+  const s32* inherit_src;
+  u32 num_inherit_fds;
+  s32 cwd;
+  bool jailed;
+  const c8* cmd;
+  const c8* const* argv;
+  const c8* const* envp;
+  sigset_t sigmask;
+  s32 pidfd;
+  sl_spawn_report_t report;
+} sl_spawn_args_t;
+
+static void sl_spawn_abort(sl_spawn_args_t* args, sl_spawn_phase_t phase, s32 exit_code) {
+  args->report.err = errno;
+  args->report.phase = phase;
+  sl_child_fail(exit_code);
+}
 
-  *sl = (sl_ctx_t){
-    .pid = -1,
-    .stdin_fd = -1,
-    .stdout_fd = -1,
-    .stderr_fd = -1,
-    .write = {.dirs = sl_alloc_n(c8*, opts->write.num_dirs), .num_dirs = opts->write.num_dirs},
-    .read = {.dirs = sl_alloc_n(c8*, opts->read.num_dirs), .num_dirs = opts->read.num_dirs},
-    .network = opts->network,
-    .platform = {
-      .abi = abi,
-    },
-  };
-  if (sl->write.num_dirs && !sl->write.dirs) {
-    sl_free((void*)sl->read.dirs);
-    sl_free(sl);
-    return SL_NULLPTR;
+/* Resets every signal the host handles (rather than ignores) to SIG_DFL. */
+static void sl_signals_reset(void) {
+  for (s32 sig = 1; sig < _NSIG; sig++) {
+    struct sigaction sa;
+    if (sigaction(sig, SL_NULLPTR, &sa) || sa.sa_handler == SIG_IGN || sa.sa_handler == SIG_DFL) {
+      continue;
+    }
+    sa.sa_handler = SIG_DFL;
+    sa.sa_flags = 0;
+    sigemptyset(&sa.sa_mask);
+    sigaction(sig, &sa, SL_NULLPTR);
   }
-  if (sl->read.num_dirs && !sl->read.dirs) {
-    sl_free((void*)sl->write.dirs);
-    sl_free(sl);
+}
+
+/*
+ * Runs on the parent's memory until exec (CLONE_VM), so `args->report` is
+ * read straight back by the parent once clone() returns.
+ */
+static int sl_spawn_child(void* userdata) {
+  sl_spawn_args_t* args = (sl_spawn_args_t*)userdata;
+  args->report.started = sl_now_ns();
+
+  /* Handlers installed by the host would run on the host's memory; reset
+   * everything that is not ignored before unblocking signals. */
+  sl_signals_reset();
+  sigprocmask(SIG_SETMASK, &args->sigmask, SL_NULLPTR);
+
+  if (sl_pipes_wire(&args->pipes)) {
+    sl_spawn_abort(args, SL_SPAWN_PHASE_STDIO, SL_CHILD_PRE_EXEC_FAILURE);
+  }
+  sl_pipes_try_close(&args->pipes);
+
+  /* From the zygote: the host's cwd, and inherited fds to put in place. */
+  if (args->cwd >= 0 && fchdir(args->cwd)) {
+    sl_spawn_abort(args, SL_SPAWN_PHASE_FDS, SL_CHILD_PRE_EXEC_FAILURE);
+  }
+  for (u32 it = 0; args->inherit_src && it < args->num_inherit_fds; it++) {
+    if (args->inherit_fds[it] > STDERR_FILENO && dup2(args->inherit_src[it], args->inherit_fds[it]) < 0) {
+      sl_spawn_abort(args, SL_SPAWN_PHASE_FDS, SL_CHILD_PRE_EXEC_FAILURE);
+    }
+  }
+
+  /* The ruleset is the one descriptor still needed, and it is CLOEXEC. */
+  if (sl_fds_sweep(args->inherit_fds, args->num_inherit_fds, args->ruleset)) {
+    sl_spawn_abort(args, SL_SPAWN_PHASE_FDS, SL_CHILD_PRE_EXEC_FAILURE);
+  }
+  args->report.stdio = sl_now_ns();
+
+  /* A fork server's children are born inside its domain. */
+  if (!args->jailed && prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0)) {
+    sl_spawn_abort(args, SL_SPAWN_PHASE_NO_NEW_PRIVS, SL_CHILD_PRE_EXEC_FAILURE);
+  }
+
+  if (!args->jailed && landlock_restrict_self(args->ruleset, 0)) {
+    sl_spawn_abort(args, SL_SPAWN_PHASE_RESTRICT, SL_CHILD_PRE_EXEC_FAILURE);
+  }
+  args->report.restricted = sl_now_ns();
+
+  args->report.exec = sl_now_ns();
+  execve(args->cmd, (char* const*)args->argv, (char* const*)args->envp);
+  sl_spawn_abort(args, SL_SPAWN_PHASE_EXEC, SL_CHILD_POST_EXEC_FAILURE);
+  return SL_CHILD_POST_EXEC_FAILURE;
+}
+
+static pid_t sl_spawn_clone(sl_spawn_args_t* args, s32 extra_flags) {
+  void* stack = mmap(SL_NULLPTR, SL_SPAWN_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+  if (stack == MAP_FAILED) {
+    return -1;
+  }
+
+  sigset_t all;
+  sigfillset(&all);
+  pthread_sigmask(SIG_BLOCK, &all, &args->sigmask);
+
+  /* pidfd_open() and CLONE_PIDFD landed one release apart (5.3 vs 5.2), so
+   * a working pidfd_open means the flag is safe to pass. */
+  s32 flags = CLONE_VM | CLONE_VFORK | SIGCHLD | extra_flags;
+  args->pidfd = -1;
+#if defined(CLONE_PIDFD)
+  if (sl_capabilities()->pidfd) flags |= CLONE_PIDFD;
+#endif
+
+  /* Stacks grow down on every architecture we build for. */
+  pid_t pid = clone(sl_spawn_child, (u8*)stack + SL_SPAWN_STACK_SIZE, flags, args, &args->pidfd);
+  s32 saved = errno;
+
+  pthread_sigmask(SIG_SETMASK, &args->sigmask, SL_NULLPTR);
+  munmap(stack, SL_SPAWN_STACK_SIZE);
+
+  errno = saved;
+  return pid;
+}
+
+/* --- zygote ------------------------------------------------------------- */
+
+/*
+ * The zygote is a fork of the host taken in sb_runtime_init() that does
+ * nothing but spawn. A request is an sl_zygote_request_t with the
+ * descriptors named in `fds` attached in SL_ZYGOTE_FD_* order, then the
+ * inherited ones; `len` bytes of payload follow: the inherit_fds targets,
+ * then argv and envp as NUL-terminated strings. The reply is an
+ * sl_zygote_reply_t with the child's pidfd attached.
+ *
+ * Children are started with CLONE_PARENT on the same trampoline as a direct
+ * spawn, so they are the host's children, not the zygote's. Anything that
+ * isn't sent along (umask, rlimits, signal dispositions) is the host's as of
+ * sb_runtime_init().
+ *
+ * The zygote was forked from a possibly multithreaded host, so it keeps to
+ * what is safe after fork(): no allocation, its buffers come from mmap().
+ */
+#define SL_ZYGOTE_FD_RULESET (1u << 0)
+#define SL_ZYGOTE_FD_STDIN (1u << 1)
+#define SL_ZYGOTE_FD_STDOUT (1u << 2)
+#define SL_ZYGOTE_FD_STDERR (1u << 3)
+#define SL_ZYGOTE_FD_CWD (1u << 4)
+#define SL_ZYGOTE_NUM_FDS 5
+#define SL_ZYGOTE_MAX_INHERIT 64
+#define SL_ZYGOTE_MAX_FDS (SL_ZYGOTE_NUM_FDS + SL_ZYGOTE_MAX_INHERIT)
+
+typedef struct {
+  u32 fds;
+  u32 num_inherit;
+  u32 num_args;
+  u32 num_env;
+  u64 len;
+  bool merge_err;
+} sl_zygote_request_t;
+
+typedef struct {
+  pid_t pid;
+  s32 err;
+  sl_spawn_report_t report;
+} sl_zygote_reply_t;
+
+static bool sl_zygote_send(s32 sock, const void* data, u64 len, const s32* fds, u32 num_fds) {
+  union {
+    struct cmsghdr align;
+    u8 buf[CMSG_SPACE(sizeof(s32) * SL_ZYGOTE_MAX_FDS)];
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct iovec iov = { .iov_base = (void*)data, .iov_len = len };
+  struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+  if (num_fds) {
+    msg.msg_control = control.buf;
+    msg.msg_controllen = CMSG_SPACE(sizeof(s32) * num_fds);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(s32) * num_fds);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(s32) * num_fds);
+  }
+
+  ssize_t n;
+  while ((n = sendmsg(sock, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR) {}
+  return n == (ssize_t)len;
+}
+
+/* Exactly `len` bytes; whatever descriptors came with them land in `fds`. */
+static bool sl_zygote_recv(s32 sock, void* data, u64 len, s32* fds, u32* num_fds) {
+  union {
+    struct cmsghdr align;
+    u8 buf[CMSG_SPACE(sizeof(s32) * SL_ZYGOTE_MAX_FDS)];
+  } control;
+
+  struct iovec iov = { .iov_base = data, .iov_len = len };
+  struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = control.buf, .msg_controllen = sizeof(control.buf) };
+  ssize_t n;
+  while ((n = recvmsg(sock, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR) {}
+
+  *num_fds = 0;
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); n > 0 && cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+    u32 count = (u32)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(s32));
+    memcpy(fds + *num_fds, CMSG_DATA(cmsg), sizeof(s32) * count);
+    *num_fds += count;
+  }
+  if (n == 0) errno = EPIPE;
+  return n == (ssize_t)len;
+}
+
+static bool sl_zygote_transfer(s32 sock, void* data, u64 len, bool out) {
+  for (u64 done = 0; done < len;) {
+    ssize_t n = out ? send(sock, (u8*)data + done, len - done, MSG_NOSIGNAL) : recv(sock, (u8*)data + done, len - done, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      if (n == 0) errno = EPIPE;
+      return false;
+    }
+    done += (u64)n;
+  }
+  return true;
+}
+
+/* Points `out[0..count)` at consecutive strings in [*it, end); NULL-terminated. */
+static bool sl_zygote_strings(const c8** it, const c8* end, const c8** out, u32 count) {
+  sl_for(n, count) {
+    const c8* nul = (const c8*)memchr(*it, 0, (u64)(end - *it));
+    if (!nul) return false;
+    out[n] = *it;
+    *it = nul + 1;
+  }
+  out[count] = SL_NULLPTR;
+  return true;
+}
+
+/* Serves one request whose header and descriptors have arrived; false if the stream is lost. */
+static bool sl_zygote_serve(s32 sock, bool jailed, const sl_zygote_request_t* req, s32* fds, u32 num_fds, u8** buf, u64* cap) {
+  u64 strings = (req->len + 7) & ~(u64)7;
+  u64 need = strings + sizeof(c8*) * ((u64)req->num_args + req->num_env + 2);
+  if (need > *cap) {
+    if (*cap) munmap(*buf, *cap);
+    *cap = (need + 0xffff) & ~(u64)0xffff;
+    *buf = (u8*)mmap(SL_NULLPTR, *cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (*buf == MAP_FAILED) return false;
+  }
+  if (!sl_zygote_transfer(sock, *buf, req->len, false)) return false;
+
+  sl_zygote_reply_t reply = { .pid = -1, .err = EINVAL };
+  u32 expected = (u32)__builtin_popcount(req->fds) + req->num_inherit;
+  const s32* targets = (const s32*)*buf;
+  const c8** argv = (const c8**)(*buf + strings);
+  const c8** envp = argv + req->num_args + 1;
+  const c8* it = (const c8*)(targets + req->num_inherit);
+  const c8* end = (const c8*)*buf + req->len;
+
+  bool valid = num_fds == expected && req->num_args && req->num_inherit <= SL_ZYGOTE_MAX_INHERIT;
+  valid = valid && (u64)req->num_inherit * sizeof(s32) <= req->len;
+  valid = valid && sl_zygote_strings(&it, end, argv, req->num_args) && sl_zygote_strings(&it, end, envp, req->num_env);
+
+  /* Move everything above the targets so putting those in place can't clobber a source. */
+  s32 floor = STDERR_FILENO + 1;
+  sl_for(n, valid ? req->num_inherit : 0) {
+    if (targets[n] >= floor) floor = targets[n] + 1;
+  }
+  sl_for(n, req->num_inherit ? num_fds : 0) {
+    s32 moved = fcntl(fds[n], F_DUPFD_CLOEXEC, floor);
+    close(fds[n]);
+    fds[n] = moved;
+  }
+
+  if (valid) {
+    u32 at = 0;
+    sl_spawn_args_t spawn = {
+      .pipes = SL_NULL_PIPES,
+      .ruleset = (req->fds & SL_ZYGOTE_FD_RULESET) ? fds[at++] : -1,
+      .cwd = -1,
+      .jailed = jailed,
+    };
+    spawn.pipes.merge_err = req->merge_err;
+    if (req->fds & SL_ZYGOTE_FD_STDIN) spawn.pipes.in[0] = fds[at++];
+    if (req->fds & SL_ZYGOTE_FD_STDOUT) spawn.pipes.out[1] = fds[at++];
+    if (req->fds & SL_ZYGOTE_FD_STDERR) spawn.pipes.err[1] = fds[at++];
+    if (req->fds & SL_ZYGOTE_FD_CWD) spawn.cwd = fds[at++];
+    spawn.inherit_fds = targets;
+    spawn.inherit_src = fds + at;
+    spawn.num_inherit_fds = req->num_inherit;
+    spawn.cmd = argv[0];
+    spawn.argv = argv;
+    spawn.envp = envp;
+
+    reply.pid = sl_spawn_clone(&spawn, CLONE_PARENT);
+    reply.err = reply.pid < 0 ? errno : 0;
+    reply.report = spawn.report;
+    if (reply.pid < 0) spawn.pidfd = -1;
+
+    /* The child's copies are its own; ours go once the reply is out. */
+    bool sent = sl_zygote_send(sock, &reply, sizeof(reply), &spawn.pidfd, spawn.pidfd >= 0 ? 1 : 0);
+    if (spawn.pidfd >= 0) close(spawn.pidfd);
+    sl_for(n, num_fds) { close(fds[n]); }
+    return sent;
+  }
+
+  sl_for(n, num_fds) {
+    if (fds[n] >= 0) close(fds[n]);
+  }
+  return sl_zygote_send(sock, &reply, sizeof(reply), SL_NULLPTR, 0);
+}
+
+/*
+ * With a `ruleset`, this is a fork server: it restricts itself first and
+ * reports how that went as one errno-sized message.
+ */
+static void sl_zygote_main(s32 sock, s32 ruleset) {
+  sl_signals_reset();
+  sigset_t none;
+  sigemptyset(&none);
+  sigprocmask(SIG_SETMASK, &none, SL_NULLPTR);
+  sl_fds_sweep(ruleset >= 0 ? &ruleset : SL_NULLPTR, ruleset >= 0 ? 1 : 0, sock);
+
+  bool jailed = ruleset >= 0;
+  if (jailed) {
+    s32 err = 0;
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) || landlock_restrict_self(ruleset, 0)) err = errno;
+    close(ruleset);
+    if (!sl_zygote_transfer(sock, &err, sizeof(err), true) || err) _exit(SL_CHILD_PRE_EXEC_FAILURE);
+  }
+
+  u8* buf = SL_NULLPTR;
+  u64 cap = 0;
+  for (;;) {
+    sl_zygote_request_t req;
+    s32 fds[SL_ZYGOTE_MAX_FDS];
+    u32 num_fds = 0;
+    if (!sl_zygote_recv(sock, &req, sizeof(req), fds, &num_fds)) break;
+    if (!sl_zygote_serve(sock, jailed, &req, fds, num_fds, &buf, &cap)) break;
+  }
+  _exit(0);
+}
+
+static sl_err_t sl_zygote_fork(sl_zygote_t* zygote, s32 ruleset) {
+  s32 socks[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, socks)) return SL_ERROR_PIPE;
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    sl_pipe_try_close(socks);
+    return SL_ERROR_FORK;
+  }
+  if (pid == 0) sl_zygote_main(socks[1], ruleset);
+
+  close(socks[1]);
+  zygote->fd = socks[0];
+  zygote->pid = pid;
+  return SL_OK;
+}
+
+static sl_err_t sl_platform_zygote_start(sl_zygote_t* zygote) {
+  return sl_zygote_fork(zygote, -1);
+}
+
+static sl_err_t sl_platform_server_start(sl_ctx_t* sb, sl_zygote_t* server) {
+  if (sl_zygote_fork(server, sb->platform.ruleset)) {
+    snprintf(sb->error, sizeof(sb->error), "fork server: %s", strerror(errno));
+    return SL_ERROR_FORK;
+  }
+
+  s32 err = EPIPE;
+  sl_zygote_transfer(server->fd, &err, sizeof(err), false);
+  if (!err) return SL_OK;
+
+  snprintf(sb->error, sizeof(sb->error), "restrict: %s", strerror(err));
+  close(server->fd);
+  int status;
+  while (waitpid(server->pid, &status, 0) < 0 && errno == EINTR) {}
+  server->fd = -1;
+  server->pid = -1;
+  return SL_ERROR_RESTRICT;
+}
+
+/* For sb_spawn_fn's child, which has no trampoline to do this for it. */
+static sl_spawn_phase_t sl_platform_restrict_self(const sl_ctx_t* sb) {
+  if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0)) return SL_SPAWN_PHASE_NO_NEW_PRIVS;
+  if (landlock_restrict_self(sb->platform.ruleset, 0)) return SL_SPAWN_PHASE_RESTRICT;
+  return SL_SPAWN_PHASE_NONE;
+}
+
+/* A fork()ed child gets no pidfd from clone, so it is opened after the fact. */
+static s32 sl_platform_pidfd_open(pid_t pid) {
+#if defined(SYS_pidfd_open)
+  if (sl_capabilities()->pidfd) return (s32)syscall(SYS_pidfd_open, pid, 0);
+#endif
+  (void)pid;
+  return -1;
+}
+
+/* A pidfd pins the process, so the signal can never reach a recycled pid. */
+static s32 sl_platform_signal(s32 pidfd, pid_t pid, s32 sig) {
+#if defined(SYS_pidfd_send_signal)
+  if (pidfd >= 0) return (s32)syscall(SYS_pidfd_send_signal, pidfd, sig, SL_NULLPTR, 0);
+#endif
+  (void)pidfd;
+  return kill(pid, sig);
+}
+
+/*
+ * Host side of a spawn through the zygote or a fork server; takes over from
+ * sl_platform_spawn with the same contract. A fork server has applied the
+ * policy already, so it gets no `ruleset` (-1).
+ */
+static sl_err_t sl_zygote_spawn(sl_ctx_t* sb, sl_zygote_t* zygote, s32 ruleset, sl_child_t* child, sl_pipes_t* pipes, const c8* const* argv, const c8* const* envp) {
+  if (sb->num_inherit_fds > SL_ZYGOTE_MAX_INHERIT) {
+    snprintf(sb->error, sizeof(sb->error), "zygote: at most %d inherited descriptors", SL_ZYGOTE_MAX_INHERIT);
+    sl_pipes_try_close(pipes);
+    return SL_ERROR_INVALID_STDIO;
+  }
+
+  sl_zygote_request_t req = { .num_inherit = sb->num_inherit_fds, .merge_err = pipes->merge_err };
+  s32 fds[SL_ZYGOTE_MAX_FDS];
+  u32 num_fds = 0;
+  s32 cwd = open(".", O_PATH | O_DIRECTORY | O_CLOEXEC);
+  s32 named[SL_ZYGOTE_NUM_FDS] = { ruleset, pipes->in[0], pipes->out[1], pipes->err[1], cwd };
+  sl_for(it, SL_ZYGOTE_NUM_FDS) {
+    if (named[it] < 0) continue;
+    req.fds |= 1u << it;
+    fds[num_fds++] = named[it];
+  }
+  sl_for(it, sb->num_inherit_fds) { fds[num_fds++] = sb->inherit_fds[it]; }
+
+  req.len = sizeof(s32) * (u64)sb->num_inherit_fds;
+  for (; argv[req.num_args]; req.num_args++) req.len += sl_cstr_len(argv[req.num_args]) + 1;
+  for (; envp[req.num_env]; req.num_env++) req.len += sl_cstr_len(envp[req.num_env]) + 1;
+
+  u8* payload = (u8*)sl_alloc(req.len ? req.len : 1);
+  if (!payload) {
+    if (cwd >= 0) close(cwd);
+    snprintf(sb->error, sizeof(sb->error), "alloc zygote request failed");
+    sl_pipes_try_close(pipes);
+    return SL_ERROR;
+  }
+  u8* at = payload;
+  memcpy(at, sb->inherit_fds, sizeof(s32) * (u64)sb->num_inherit_fds);
+  at += sizeof(s32) * (u64)sb->num_inherit_fds;
+  sl_for(it, req.num_args) {
+    u64 len = sl_cstr_len(argv[it]) + 1;
+    memcpy(at, argv[it], len);
+    at += len;
+  }
+  sl_for(it, req.num_env) {
+    u64 len = sl_cstr_len(envp[it]) + 1;
+    memcpy(at, envp[it], len);
+    at += len;
+  }
+
+  u64 fork_start = sl_now_ns();
+  sl_zygote_reply_t reply = { .pid = -1 };
+  s32 pidfd = -1;
+  u32 num_pidfds = 0;
+
+  pthread_mutex_lock(&zygote->lock);
+  s32 sock = zygote->fd;
+  errno = EPIPE;
+  bool ok = sock >= 0 && sl_zygote_send(sock, &req, sizeof(req), fds, num_fds) &&
+            sl_zygote_transfer(sock, payload, req.len, true) &&
+            sl_zygote_recv(sock, &reply, sizeof(reply), &pidfd, &num_pidfds);
+  s32 saved = errno;
+  pthread_mutex_unlock(&zygote->lock);
+
+  sl_free(payload);
+  if (cwd >= 0) close(cwd);
+  if (!num_pidfds) pidfd = -1;
+
+  if (!ok || reply.pid < 0) {
+    if (pidfd >= 0) close(pidfd);
+    sl_pipes_try_close(pipes);
+    snprintf(sb->error, sizeof(sb->error), "%s: %s", ok ? "clone" : "zygote", strerror(ok ? reply.err : saved));
+    return SL_ERROR_FORK;
+  }
+
+  sl_stats_record(&sb->stats, &reply.report, fork_start, sl_now_ns());
+  sl_err_t err = sl_spawn_check_report(sb, reply.pid, pipes, &reply.report, argv[0]);
+  if (err) {
+    if (pidfd >= 0) close(pidfd);
+    return err;
+  }
+  sl_child_adopt(child, reply.pid, pipes);
+  child->pidfd = pidfd;
+  return SL_OK;
+}
+
+/* --- public API --------------------------------------------------------- */
+
+sl_ctx_t* sb_create(const sb_opts_t* opts) {
+  if (!opts) return SL_NULLPTR;
+  if (opts->write.num_dirs > 0 && !opts->write.dirs) return SL_NULLPTR;
+  if (opts->read.num_dirs > 0 && !opts->read.dirs) return SL_NULLPTR;
+  if (opts->num_inherit_fds > SL_ZYGOTE_MAX_INHERIT && sl_rt.zygote.fd >= 0) return SL_NULLPTR;
+
+  s32 abi = sl_capabilities()->abi;
+  if (abi < 0) return SL_NULLPTR;
+
+  sl_ctx_t* sl = sl_alloc(sizeof(sl_ctx_t));
+  if (!sl) return SL_NULLPTR;
+
+  *sl = (sl_ctx_t){
+    .write = {.dirs = sl_alloc_n(c8*, opts->write.num_dirs), .num_dirs = opts->write.num_dirs},
+    .read = {.dirs = sl_alloc_n(c8*, opts->read.num_dirs), .num_dirs = opts->read.num_dirs},
+    .network = opts->network,
+    .stdio = opts->stdio,
+    .pipe_size = opts->pipe_size,
+    .pipe_flags = opts->pipe_flags,
+    .platform = {
+      .abi = abi,
+      .ruleset = -1,
+    },
+  };
+  sl_child_init(&sl->child);
+  if (sl->write.num_dirs && !sl->write.dirs) {
+    sl_free((void*)sl->read.dirs);
+    sl_free(sl);
+    return SL_NULLPTR;
+  }
+  if (sl->read.num_dirs && !sl->read.dirs) {
+    sl_free((void*)sl->write.dirs);
+    sl_free(sl);
+    return SL_NULLPTR;
+  }
+
+  sl->inherit_fds = sl_fds_copy(opts->inherit_fds, opts->num_inherit_fds);
+  sl->num_inherit_fds = sl->inherit_fds ? opts->num_inherit_fds : 0;
+  if (opts->num_inherit_fds && !sl->inherit_fds) {
+    sb_destroy(sl);
+    return SL_NULLPTR;
+  }
+
+  sl->platform.write_fds = sl_alloc_fds(sl->write.num_dirs);
+  sl->platform.read_fds = sl_alloc_fds(sl->read.num_dirs);
+  if ((sl->write.num_dirs && !sl->platform.write_fds) || (sl->read.num_dirs && !sl->platform.read_fds)) {
+    sb_destroy(sl);
     return SL_NULLPTR;
   }
 
@@ -656,575 +1802,2684 @@ sl_ctx_t* sb_create(const sb_opts_t* opts) {
     }
   }
 
+  /* A scope that fails to compile is reported by sb_spawn, not here */
+  u64 start = sl_now_ns();
+  sl->platform.ruleset_err = sl_open_scope(&sl->write, sl->platform.write_fds, "write", sl->error, sizeof(sl->error));
+  if (!sl->platform.ruleset_err) {
+    sl->platform.ruleset_err = sl_open_scope(&sl->read, sl->platform.read_fds, "read", sl->error, sizeof(sl->error));
+  }
+  sl->stats.scope_ns = sl_now_ns() - start;
+
+  start = sl_now_ns();
+  if (!sl->platform.ruleset_err) {
+    sl->platform.ruleset_err = build_ruleset(sl, &sl->platform.ruleset);
+  }
+  sl->stats.ruleset_ns = sl_now_ns() - start;
+
   return sl;
 }
 
-sl_err_t sb_spawn(sl_ctx_t* sb, const c8* cmd, const c8* const* args, u32 num_args, sl_env_t env) {
+static sl_err_t sl_platform_check(const sl_ctx_t* sb) {
+  return sb->platform.ruleset_err;
+}
+
+static s32 sl_platform_memfd(const c8* name) {
+  return memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+}
+
+/*
+ * An exited child doesn't mean nothing holds the memfd: a grandchild that
+ * shrank it under the mapping would SIGBUS whoever reads it. So it is sealed
+ * against shrinking first, and against growing and writing where the kernel
+ * allows (the write seal fails while anyone has it mapped shared).
+ */
+static s32 sl_platform_output_map(s32 fd, sl_output_t* out) {
+  if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK)) return -1;
+  fcntl(fd, F_ADD_SEALS, F_SEAL_GROW);
+  fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE);
+
+  struct stat st;
+  if (fstat(fd, &st)) return -1;
+  if (!st.st_size) return 0;
+
+  void* data = mmap(SL_NULLPTR, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) return -1;
+  *out = (sl_output_t){ .data = (u8*)data, .len = (u64)st.st_size };
+  return 0;
+}
+
+static s32 sl_platform_pipe(s32 fds[2]) {
+  return pipe2(fds, O_CLOEXEC);
+}
+
+typedef struct {
+  u64 ino;
+  s64 off;
+  u16 reclen;
+  u8 type;
+  c8 name[];
+} sl_dirent64_t;
+
+/*
+ * close_range(2) needs 5.9; before that, walk /proc/self/fd. Called from the
+ * CLONE_VM child, so it's raw syscalls and a buffer on the stack.
+ */
+static s32 sl_platform_close_range(u32 from, u32 to) {
+#if defined(SYS_close_range)
+  if (!syscall(SYS_close_range, from, to, 0)) return 0;
+  if (errno != ENOSYS) return -1;
+#endif
+
+  s32 dir = open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir < 0) return -1;
+
+  u64 buf[512];
+  for (;;) {
+    long n = syscall(SYS_getdents64, dir, buf, sizeof(buf));
+    if (n <= 0) {
+      close(dir);
+      return n < 0 ? -1 : 0;
+    }
+
+    for (long at = 0; at < n;) {
+      const sl_dirent64_t* entry = (const sl_dirent64_t*)((const u8*)buf + at);
+      at += entry->reclen;
+
+      u64 fd = 0;
+      const c8* it = entry->name;
+      for (; *it >= '0' && *it <= '9'; it++) fd = fd * 10 + (u64)(*it - '0');
+      if (it == entry->name || *it || fd < from || fd > to || (s32)fd == dir) continue;
+      close((s32)fd);
+    }
+  }
+}
+
+/* --- loop --------------------------------------------------------------- */
+
+/*
+ * The io_uring backend, spoken through the raw syscalls (no liburing). Reads
+ * are IORING_OP_READ_MULTISHOT with buffer selection from one provided
+ * buffer ring carved out of loop->buffer; a completion names the buffer it
+ * filled, which stays lent out until the next wait hands it back. Pipes
+ * whose multishot read stopped (buffers ran dry, or the kernel ended it
+ * early) are re-armed at the start of the next wait, in the same
+ * io_uring_enter() that reaps. Exits are a one-shot poll on the pidfd.
+ * Cancels carry SL_URING_IGNORE so their own completions are dropped.
+ */
+#define SL_URING_ENTRIES 256
+#define SL_URING_CQ_ENTRIES 4096
+#define SL_URING_BUFS 64
+#define SL_URING_BUF_SIZE (SL_LOOP_BUFFER / SL_URING_BUFS)
+#define SL_URING_GROUP 0
+#define SL_URING_IGNORE UINT64_MAX
+
+/* Linux 6.7; older uapi headers don't name it. */
+#define SL_IORING_OP_READ_MULTISHOT 49
+
+struct sl_uring {
+  s32 fd;
+  void* ring;
+  u64 ring_len;
+  struct io_uring_sqe* sqes;
+  u64 sqes_len;
+  u32* sq_head;
+  u32* sq_tail;
+  u32* sq_array;
+  u32 sq_mask;
+  u32 sq_entries;
+  u32 tail;
+  u32* cq_head;
+  u32* cq_tail;
+  u32 cq_mask;
+  struct io_uring_cqe* cqes;
+  struct io_uring_buf_ring* bufs;
+  u8* buffer;
+  u16 buf_tail;
+  u16 lent[SL_URING_BUFS];
+  u32 num_lent;
+  u64 rearm[SL_LOOP_MAX_READY];
+  u32 num_rearm;
+};
+
+static inline s32 sl_io_uring_setup(u32 entries, struct io_uring_params* params) {
+  return (s32)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static inline s32 sl_io_uring_enter(s32 fd, u32 to_submit, u32 min_complete, u32 flags, void* arg, u64 arg_len) {
+  return (s32)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_len);
+}
+
+static inline s32 sl_io_uring_register(s32 fd, u32 op, void* arg, u32 num_args) {
+  return (s32)syscall(__NR_io_uring_register, fd, op, arg, num_args);
+}
+
+/* A ring can be made, waited on with a timeout, and runs multishot reads. */
+static bool sl_uring_probe(void) {
+  struct io_uring_params params = SL_ZERO;
+  s32 fd = sl_io_uring_setup(2, &params);
+  if (fd < 0) return false;
+
+  u32 features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+  bool ok = (params.features & features) == features;
+
+  u64 size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+  struct io_uring_probe* probe = (struct io_uring_probe*)sl_alloc(size);
+  ok = ok && probe && sl_io_uring_register(fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+  u32 ops[] = { SL_IORING_OP_READ_MULTISHOT, IORING_OP_POLL_ADD, IORING_OP_ASYNC_CANCEL };
+  sl_for(it, 3) {
+    ok = ok && ops[it] < probe->ops_len && (probe->ops[ops[it]].flags & IO_URING_OP_SUPPORTED);
+  }
+
+  sl_free(probe);
+  close(fd);
+  return ok;
+}
+
+static void sl_uring_close(sl_uring_t* uring) {
+  if (!uring) return;
+  if (uring->fd >= 0) close(uring->fd);
+  if (uring->ring) munmap(uring->ring, uring->ring_len);
+  if (uring->sqes) munmap(uring->sqes, uring->sqes_len);
+  if (uring->bufs) munmap(uring->bufs, SL_URING_BUFS * sizeof(struct io_uring_buf));
+  sl_free(uring);
+}
+
+static void sl_uring_give(sl_uring_t* uring, u16 bid) {
+  struct io_uring_buf* buf = &uring->bufs->bufs[uring->buf_tail & (SL_URING_BUFS - 1)];
+  buf->addr = (u64)(uintptr_t)(uring->buffer + (u64)bid * SL_URING_BUF_SIZE);
+  buf->len = SL_URING_BUF_SIZE;
+  buf->bid = bid;
+  uring->buf_tail++;
+}
+
+static void sl_uring_publish(sl_uring_t* uring) {
+  __atomic_store_n(&uring->bufs->tail, uring->buf_tail, __ATOMIC_RELEASE);
+}
+
+/* Maps the rings and registers `buffer` (SL_LOOP_BUFFER bytes) as the reads' buffer ring. */
+static sl_uring_t* sl_uring_open(u8* buffer) {
+  sl_uring_t* uring = sl_alloc_t(sl_uring_t);
+  if (!uring) return SL_NULLPTR;
+  uring->fd = -1;
+  uring->buffer = buffer;
+
+  struct io_uring_params params = SL_ZERO;
+  params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+  params.cq_entries = SL_URING_CQ_ENTRIES;
+  uring->fd = sl_io_uring_setup(SL_URING_ENTRIES, &params);
+  if (uring->fd < 0) {
+    sl_uring_close(uring);
+    return SL_NULLPTR;
+  }
+
+  /* One mapping holds both rings (IORING_FEAT_SINGLE_MMAP, checked by the probe) */
+  u64 sq_len = params.sq_off.array + params.sq_entries * sizeof(u32);
+  u64 cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  uring->ring_len = sq_len > cq_len ? sq_len : cq_len;
+  uring->ring = mmap(SL_NULLPTR, uring->ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+  if (uring->ring == MAP_FAILED) {
+    uring->ring = SL_NULLPTR;
+    sl_uring_close(uring);
+    return SL_NULLPTR;
+  }
+
+  uring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+  uring->sqes = (struct io_uring_sqe*)mmap(SL_NULLPTR, uring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+  if (uring->sqes == MAP_FAILED) {
+    uring->sqes = SL_NULLPTR;
+    sl_uring_close(uring);
+    return SL_NULLPTR;
+  }
+
+  u8* ring = (u8*)uring->ring;
+  uring->sq_head = (u32*)(ring + params.sq_off.head);
+  uring->sq_tail = (u32*)(ring + params.sq_off.tail);
+  uring->sq_array = (u32*)(ring + params.sq_off.array);
+  uring->sq_mask = *(u32*)(ring + params.sq_off.ring_mask);
+  uring->sq_entries = params.sq_entries;
+  uring->tail = *uring->sq_tail;
+  uring->cq_head = (u32*)(ring + params.cq_off.head);
+  uring->cq_tail = (u32*)(ring + params.cq_off.tail);
+  uring->cq_mask = *(u32*)(ring + params.cq_off.ring_mask);
+  uring->cqes = (struct io_uring_cqe*)(ring + params.cq_off.cqes);
+
+  uring->bufs = (struct io_uring_buf_ring*)mmap(SL_NULLPTR, SL_URING_BUFS * sizeof(struct io_uring_buf), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (uring->bufs == MAP_FAILED) {
+    uring->bufs = SL_NULLPTR;
+    sl_uring_close(uring);
+    return SL_NULLPTR;
+  }
+
+  struct io_uring_buf_reg reg = {
+    .ring_addr = (u64)(uintptr_t)uring->bufs,
+    .ring_entries = SL_URING_BUFS,
+    .bgid = SL_URING_GROUP,
+  };
+  if (sl_io_uring_register(uring->fd, IORING_REGISTER_PBUF_RING, &reg, 1)) {
+    sl_uring_close(uring);
+    return SL_NULLPTR;
+  }
+
+  sl_for(it, SL_URING_BUFS) { sl_uring_give(uring, (u16)it); }
+  sl_uring_publish(uring);
+  return uring;
+}
+
+/* Hands everything queued to the kernel without waiting. */
+static bool sl_uring_submit(sl_uring_t* uring) {
+  __atomic_store_n(uring->sq_tail, uring->tail, __ATOMIC_RELEASE);
+  u32 pending = uring->tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+  if (!pending) return true;
+
+  s32 n = sl_io_uring_enter(uring->fd, pending, 0, 0, SL_NULLPTR, 0);
+  return n >= 0 || errno == EINTR || errno == EAGAIN || errno == EBUSY;
+}
+
+static struct io_uring_sqe* sl_uring_sqe(sl_uring_t* uring) {
+  if (uring->tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >= uring->sq_entries) {
+    sl_uring_submit(uring);
+    if (uring->tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >= uring->sq_entries) return SL_NULLPTR;
+  }
+
+  u32 index = uring->tail & uring->sq_mask;
+  struct io_uring_sqe* sqe = &uring->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  uring->sq_array[index] = index;
+  uring->tail++;
+  return sqe;
+}
+
+static bool sl_uring_arm(sl_uring_t* uring, sl_loop_watch_t watch, s32 fd, u64 token) {
+  struct io_uring_sqe* sqe = sl_uring_sqe(uring);
+  if (!sqe) {
+    errno = EBUSY;
+    return false;
+  }
+
+  sqe->fd = fd;
+  sqe->user_data = token;
+  if (watch == SL_LOOP_WATCH_EXIT) {
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->poll32_events = POLLIN;
+    return true;
+  }
+
+  sqe->opcode = SL_IORING_OP_READ_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = SL_URING_GROUP;
+  return true;
+}
+
+static void sl_uring_cancel(sl_uring_t* uring, u64 token) {
+  struct io_uring_sqe* sqe = sl_uring_sqe(uring);
+  if (!sqe) return;
+
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = token;
+  sqe->user_data = SL_URING_IGNORE;
+}
+
+/*
+ * Gives back the buffers the last batch lent out, re-arms stopped reads,
+ * then submits all of it and (if nothing is waiting already) blocks for a
+ * completion in one io_uring_enter(). Reaps at most `max`.
+ */
+static s32 sl_uring_wait(sl_loop_t* loop, sl_loop_ready_t* ready, u32 max, s32 timeout_ms) {
+  sl_uring_t* uring = loop->uring;
+
+  sl_for(it, uring->num_lent) { sl_uring_give(uring, uring->lent[it]); }
+  if (uring->num_lent) sl_uring_publish(uring);
+  uring->num_lent = 0;
+
+  sl_for(it, uring->num_rearm) {
+    u64 token = uring->rearm[it];
+    u32 slot = (u32)(token >> 32);
+    sl_loop_watch_t watch = (sl_loop_watch_t)(token & 3);
+    if (slot >= loop->num_entries) continue;
+
+    sl_loop_entry_t* entry = &loop->entries[slot];
+    if (!entry->live || !entry->watched[watch]) continue;
+    if (((token >> 2) & SL_LOOP_GEN_MASK) != (entry->gen & SL_LOOP_GEN_MASK)) continue;
+    sl_uring_arm(uring, watch, sl_loop_child_fd(entry->child, watch), token);
+  }
+  uring->num_rearm = 0;
+
+  __atomic_store_n(uring->sq_tail, uring->tail, __ATOMIC_RELEASE);
+  u32 pending = uring->tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+  bool empty = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE) == *uring->cq_head;
+  u32 wait = empty && timeout_ms ? 1 : 0;
+
+  if (pending || wait) {
+    struct __kernel_timespec timeout = { .tv_sec = timeout_ms / 1000, .tv_nsec = (long long)(timeout_ms % 1000) * 1000000 };
+    struct io_uring_getevents_arg arg = { .ts = timeout_ms < 0 ? 0 : (u64)(uintptr_t)&timeout };
+    u32 flags = wait ? IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG : 0;
+    s32 n = sl_io_uring_enter(uring->fd, pending, wait, flags, wait ? &arg : SL_NULLPTR, wait ? sizeof(arg) : 0);
+    if (n < 0 && errno != ETIME && errno != EBUSY) return -1;
+  }
+
+  u32 count = 0;
+  u32 head = *uring->cq_head;
+  u32 tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+  for (; head != tail && count < max && uring->num_rearm < SL_LOOP_MAX_READY; head++) {
+    struct io_uring_cqe* cqe = &uring->cqes[head & uring->cq_mask];
+    if (cqe->user_data == SL_URING_IGNORE) continue;
+
+    const u8* data = SL_NULLPTR;
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+      u16 bid = (u16)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+      uring->lent[uring->num_lent++] = bid;
+      data = uring->buffer + (u64)bid * SL_URING_BUF_SIZE;
+    }
+
+    bool output = (cqe->user_data & 3) != SL_LOOP_WATCH_EXIT;
+    bool stopped = !(cqe->flags & IORING_CQE_F_MORE);
+    if (output && stopped && (cqe->res > 0 || cqe->res == -ENOBUFS)) uring->rearm[uring->num_rearm++] = cqe->user_data;
+    if (output && cqe->res == -ENOBUFS) continue;
+
+    ready[count++] = (sl_loop_ready_t){ .token = cqe->user_data, .data = data, .res = cqe->res, .done = true };
+  }
+  __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+  return (s32)count;
+}
+
+/*
+ * io_uring unless the caller asked for epoll, or the kernel can't or won't
+ * (sl_caps_t.io_uring); an explicit SL_LOOP_BACKEND_IO_URING fails instead.
+ */
+static bool sl_platform_loop_open(sl_loop_t* loop, sl_loop_backend_t backend) {
+  if (backend != SL_LOOP_BACKEND_POLL && sl_capabilities()->io_uring) {
+    loop->uring = sl_uring_open(loop->buffer);
+    if (loop->uring) {
+      loop->fd = loop->uring->fd;
+      return true;
+    }
+  }
+  if (backend == SL_LOOP_BACKEND_IO_URING) {
+    if (!sl_capabilities()->io_uring) errno = ENOSYS;
+    return false;
+  }
+
+  loop->fd = epoll_create1(EPOLL_CLOEXEC);
+  return loop->fd >= 0;
+}
+
+static void sl_platform_loop_close(sl_loop_t* loop) {
+  if (loop->uring) {
+    sl_uring_close(loop->uring);
+    return;
+  }
+  if (loop->fd >= 0) close(loop->fd);
+}
+
+/* Exits are watched through the pidfd; without one the caller falls back. */
+static bool sl_platform_loop_watch(sl_loop_t* loop, sl_loop_watch_t watch, const sl_child_t* child, u64 token) {
+  s32 fd = sl_loop_child_fd(child, watch);
+  if (fd < 0) return false;
+  if (loop->uring) return sl_uring_arm(loop->uring, watch, fd, token);
+
+  struct epoll_event event = { .events = EPOLLIN, .data.u64 = token };
+  return epoll_ctl(loop->fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+static void sl_platform_loop_unwatch(sl_loop_t* loop, sl_loop_watch_t watch, const sl_child_t* child, u64 token) {
+  if (loop->uring) {
+    sl_uring_cancel(loop->uring, token);
+    return;
+  }
+
+  s32 fd = sl_loop_child_fd(child, watch);
+  if (fd >= 0) epoll_ctl(loop->fd, EPOLL_CTL_DEL, fd, SL_NULLPTR);
+}
+
+/* Watches and unwatches are queued on io_uring; this sends them as one batch. */
+static bool sl_platform_loop_commit(sl_loop_t* loop) {
+  return !loop->uring || sl_uring_submit(loop->uring);
+}
+
+static s32 sl_platform_loop_wait(sl_loop_t* loop, sl_loop_ready_t* ready, u32 max, s32 timeout_ms) {
+  if (loop->uring) return sl_uring_wait(loop, ready, max, timeout_ms);
+
+  struct epoll_event events[SL_LOOP_MAX_READY];
+  s32 n = epoll_wait(loop->fd, events, (s32)(max < SL_LOOP_MAX_READY ? max : SL_LOOP_MAX_READY), timeout_ms);
+  sl_for(it, (n > 0 ? (u32)n : 0)) { ready[it] = (sl_loop_ready_t){ .token = events[it].data.u64 }; }
+  return n;
+}
+
+/*
+ * Start one child on `pipes` with `argv` (argv[0] is the command). The
+ * pipes are consumed either way: the child's ends are closed on success and
+ * all of them on failure.
+ */
+static sl_err_t sl_platform_spawn(sl_ctx_t* sb, sl_child_t* child, sl_zygote_t* server, sl_pipes_t* pipes, const c8* const* argv, sl_env_t env) {
+  extern char** environ;
+  sl_spawn_args_t spawn = {
+    .pipes = *pipes,
+    .ruleset = sb->platform.ruleset,
+    .inherit_fds = sb->inherit_fds,
+    .num_inherit_fds = sb->num_inherit_fds,
+    .cwd = -1,
+    .cmd = argv[0],
+    .argv = argv,
+    .envp = env ? env : (const c8* const*)environ,
+  };
+  if (server) return sl_zygote_spawn(sb, server, -1, child, pipes, argv, spawn.envp);
+  if (sl_rt.zygote.fd >= 0) return sl_zygote_spawn(sb, &sl_rt.zygote, sb->platform.ruleset, child, pipes, argv, spawn.envp);
+
+  u64 fork_start = sl_now_ns();
+  pid_t pid = sl_spawn_clone(&spawn, 0);
+
+  if (sl_is_parent(pid)) {
+    sl_stats_record(&sb->stats, &spawn.report, fork_start, sl_now_ns());
+    sp_try(sl_spawn_check_report(sb, pid, pipes, &spawn.report, argv[0]));
+    sl_child_adopt(child, pid, pipes);
+    child->pidfd = spawn.pidfd;
+    return SL_OK;
+  }
+
+  s32 saved = errno;
+  sl_pipes_try_close(pipes);
+  snprintf(sb->error, sizeof(sb->error), "clone: %s", strerror(saved));
+  return SL_ERROR_FORK;
+}
+
+/*
+ * One round of forwarding. With SL_FORWARD_TEE, tee(2) first duplicates
+ * what is sitting in the child's pipe into our copy pipe without consuming
+ * it, and exactly that much is then spliced on; otherwise a single
+ * splice(2) moves whatever is there. Only the kept copy is ever read into
+ * user memory. Destinations splice refuses (O_APPEND files, filesystems
+ * without splice_write) fall back to read/write for the rest of the stream.
+ */
+static bool sl_platform_forward(sl_forward_t* fw) {
+  bool tee_copy = fw->flags & SL_FORWARD_TEE;
+  if (!fw->splice) return sl_forward_copy(fw, SL_FORWARD_CHUNK, tee_copy);
+
+  u64 left = SL_FORWARD_CHUNK;
+  if (tee_copy) {
+    if (fw->copy[0] < 0 && sl_platform_pipe(fw->copy)) return sl_forward_fail(fw, "pipe");
+
+    ssize_t n = tee(fw->src, fw->copy[1], SL_FORWARD_CHUNK, SPLICE_F_NONBLOCK);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) return true;
+    if (n < 0) return sl_forward_fail(fw, "tee");
+    if (n == 0) return false;
+    if (!sl_forward_reserve(fw, (u64)n)) return false;
+
+    for (u64 got = 0; got < (u64)n;) {
+      ssize_t r = read(fw->copy[0], fw->keep + fw->keep_len + got, (u64)n - got);
+      if (r < 0 && errno == EINTR) continue;
+      if (r <= 0) return sl_forward_fail(fw, "read");
+      got += (u64)r;
+    }
+    fw->keep_len += (u64)n;
+    left = (u64)n;
+  }
+
+  while (left) {
+    ssize_t n = splice(fw->src, SL_NULLPTR, fw->dest, SL_NULLPTR, left, SPLICE_F_MOVE);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && errno == EAGAIN) {
+      if (!sl_forward_wait_dest(fw)) return false;
+      if (!tee_copy) return true;
+      continue;
+    }
+    if (n < 0 && errno == EINVAL) {
+      fw->splice = false;
+      break;
+    }
+    if (n < 0) return sl_forward_fail(fw, "splice");
+    if (n == 0) return false;
+
+    fw->bytes += (u64)n;
+    if (!tee_copy) return true;
+    left -= (u64)n;
+  }
+
+  /* splice gave up part way: move the rest of what was already kept */
+  while (tee_copy && left) {
+    u64 before = fw->bytes;
+    if (!sl_forward_copy(fw, left, false)) return false;
+    left -= fw->bytes - before;
+  }
+  return true;
+}
+
+/*
+ * One write into the child's stdin pipe; gifts are vmspliced, not copied.
+ * RWF_NOWAIT makes a plain write non-blocking per call; kernels whose pipes
+ * don't accept it fall back to sl_write_nowait().
+ */
+static ssize_t sl_platform_write_stdin(s32 fd, const u8* buf, u64 len, u32 flags) {
+  struct iovec iov = { .iov_base = (void*)buf, .iov_len = len };
+  if (!(flags & SL_WRITE_NONBLOCK) && !(flags & SL_WRITE_GIFT)) return write(fd, buf, len);
+  if (!(flags & SL_WRITE_GIFT)) {
+#if defined(RWF_NOWAIT)
+    ssize_t n = pwritev2(fd, &iov, 1, -1, RWF_NOWAIT);
+    if (n >= 0 || errno != EOPNOTSUPP) return n;
+#endif
+    return sl_write_nowait(fd, buf, len);
+  }
+
+  u32 splice_flags = SPLICE_F_GIFT | ((flags & SL_WRITE_NONBLOCK) ? SPLICE_F_NONBLOCK : 0);
+  return vmsplice(fd, &iov, 1, splice_flags);
+}
+
+/* Never shrinks; past pipe-max-size (or the user's pipe quota) it stays as is. */
+static void sl_platform_pipe_grow(s32 fd, u64 size) {
+  s32 current = fcntl(fd, F_GETPIPE_SZ);
+  if (current < 0 || (u64)current >= size) return;
+  fcntl(fd, F_SETPIPE_SZ, (s32)size);
+}
+
+void sb_destroy(sl_ctx_t* sb) {
+  if (!sb || sb->destroyed) return;
+  sb->destroyed = 1;
+
+  sl_child_release(&sb->child);
+  if (sb->platform.ruleset >= 0) close(sb->platform.ruleset);
+  sl_close_fds(sb->platform.write_fds, sb->write.num_dirs);
+  sl_close_fds(sb->platform.read_fds, sb->read.num_dirs);
+  sl_free(sb->inherit_fds);
+  for (u32 i = 0; i < sb->write.num_dirs; i++)
+    sl_free((void*)sb->write.dirs[i]);
+  sl_free((void*)sb->write.dirs);
+  for (u32 i = 0; i < sb->read.num_dirs; i++)
+    sl_free((void*)sb->read.dirs[i]);
+  sl_free((void*)sb->read.dirs);
+  sl_free(sb);
+}
+
+#endif
+
+#if defined(SL_MACOS)
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/event.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* --- private sandbox API ------------------------------------------------ */
+
+typedef int (*sandbox_init_fn)(const char* profile, uint64_t flags, const char* const params[], char** errorbuf);
+typedef void (*sandbox_free_error_fn)(char* errorbuf);
+
+static sandbox_init_fn sb_init_fn;
+static sandbox_free_error_fn sb_free_fn;
+
+static int sb_load_dylib(void) {
+  static int loaded = -1;
+  if (loaded != -1) return loaded;
+
+  void* lib = dlopen("/usr/lib/system/libsystem_sandbox.dylib", RTLD_LAZY);
+  if (!lib) {
+    loaded = 0;
+    return 0;
+  }
+
+  sb_init_fn = (sandbox_init_fn)dlsym(lib, "sandbox_init_with_parameters");
+  sb_free_fn = (sandbox_free_error_fn)dlsym(lib, "sandbox_free_error");
+  loaded = (sb_init_fn && sb_free_fn) ? 1 : 0;
+  return loaded;
+}
+
+static void sl_probe_capabilities(sl_caps_t* caps) {
+  *caps = (sl_caps_t){
+    .available = sb_load_dylib() == 1,
+    .abi = -1,
+  };
+}
+
+/* --- scope validation --------------------------------------------------- */
+
+static sl_err_t sl_validate_scope(const sl_scope_t* scope, const c8* kind, c8* err, u64 err_len) {
+  if (!scope || !scope->num_dirs) {
+    return SL_OK;
+  }
+
+  for (u32 i = 0; i < scope->num_dirs; i++) {
+    const c8* path = scope->dirs[i];
+    if (!path || !path[0]) {
+      snprintf(err, err_len, "%s scope[%u] is empty", kind, i);
+      return SL_ERROR_INVALID_SCOPE;
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+      snprintf(err, err_len, "%s scope[%u] stat(%s): %s", kind, i, path, strerror(errno));
+      return SL_ERROR_INVALID_SCOPE;
+    }
+
+    if (!S_ISDIR(st.st_mode)) {
+      snprintf(err, err_len, "%s scope[%u] is not a directory: %s", kind, i, path);
+      return SL_ERROR_INVALID_SCOPE;
+    }
+  }
+
+  return SL_OK;
+}
+
+static sl_err_t sl_validate_ctx_scopes(sl_ctx_t* sb) {
+  if (!sb) {
+    return SL_ERROR_INVALID_CONTEXT;
+  }
+
+  sp_try(sl_validate_scope(&sb->read, "read", sb->error, sizeof(sb->error)));
+  sp_try(sl_validate_scope(&sb->write, "write", sb->error, sizeof(sb->error)));
+  return SL_OK;
+}
+
+/* --- profile generation ------------------------------------------------- */
+
+typedef struct {
+  c8* data;
+  u64 len;
+  u64 cap;
+} sl_profile_builder_t;
+
+static bool sl_profile_reserve(sl_profile_builder_t* builder, u64 append_len) {
+  if (!builder) {
+    return false;
+  }
+
+  u64 required = builder->len + append_len + 1;
+  if (required <= builder->cap) {
+    return true;
+  }
+
+  u64 cap = builder->cap;
+  if (!cap) {
+    cap = 4096;
+  }
+
+  while (cap < required) {
+    if (cap > (UINT64_MAX / 2)) {
+      return false;
+    }
+    cap *= 2;
+  }
+
+  c8* next = sl_allocator_realloc(sl_rt.gpa, builder->data, cap);
+  if (!next) {
+    return false;
+  }
+
+  builder->data = next;
+  builder->cap = cap;
+  return true;
+}
+
+static bool sl_profile_append_n(sl_profile_builder_t* builder, const c8* value, u64 len) {
+  if (!len) {
+    return true;
+  }
+  if (!value) {
+    return false;
+  }
+  if (!sl_profile_reserve(builder, len)) {
+    return false;
+  }
+
+  memcpy(builder->data + builder->len, value, len);
+  builder->len += len;
+  builder->data[builder->len] = 0;
+  return true;
+}
+
+static bool sl_profile_append(sl_profile_builder_t* builder, const c8* value) {
+  if (!value) {
+    return false;
+  }
+  return sl_profile_append_n(builder, value, sl_cstr_len(value));
+}
+
+static bool sl_profile_append_ch(sl_profile_builder_t* builder, c8 ch) {
+  return sl_profile_append_n(builder, &ch, 1);
+}
+
+static bool sl_profile_append_escaped_path(sl_profile_builder_t* builder, const c8* path) {
+  if (!path || !path[0]) {
+    return false;
+  }
+
+  for (u32 it = 0; path[it]; it++) {
+    c8 ch = path[it];
+    if (ch == '\\' || ch == '"') {
+      if (!sl_profile_append_ch(builder, '\\')) {
+        return false;
+      }
+    }
+    if (!sl_profile_append_ch(builder, ch)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static bool sl_profile_append_subpath(sl_profile_builder_t* builder, const c8* action, const c8* path) {
+  if (!action || !path || !path[0]) {
+    return false;
+  }
+
+  if (!sl_profile_append_ch(builder, '(')) {
+    return false;
+  }
+  if (!sl_profile_append(builder, action)) {
+    return false;
+  }
+  if (!sl_profile_append(builder, " (subpath \"")) {
+    return false;
+  }
+  if (!sl_profile_append_escaped_path(builder, path)) {
+    return false;
+  }
+  if (!sl_profile_append(builder, "\"))")) {
+    return false;
+  }
+
+  return true;
+}
+
+static bool sl_profile_append_subpath_resolved(sl_profile_builder_t* builder, const c8* action, const c8* path) {
+  if (!sl_profile_append_subpath(builder, action, path)) {
+    return false;
+  }
+
+  c8 resolved[PATH_MAX] = SL_ZERO;
+  if (!realpath(path, resolved)) {
+    return true;
+  }
+  if (!strcmp(path, resolved)) {
+    return true;
+  }
+
+  return sl_profile_append_subpath(builder, action, resolved);
+}
+
+static c8* build_profile(const sb_opts_t* opts) {
+  if (!opts) {
+    return SL_NULLPTR;
+  }
+
+  sl_profile_builder_t profile = {
+    .data = sl_alloc_n(c8, 4096),
+    .cap = 4096,
+  };
+  if (!profile.data) {
+    return SL_NULLPTR;
+  }
+  profile.data[0] = 0;
+
+  if (!sl_profile_append(&profile, "(version 1)")) goto fail;
+  if (!sl_profile_append(&profile, "(deny default (with no-log))")) goto fail;
+  if (!sl_profile_append(&profile, "(allow process*)")) goto fail;
+  if (!sl_profile_append(&profile, "(allow sysctl-read)")) goto fail;
+  if (!sl_profile_append(&profile, "(allow mach*)")) goto fail;
+  if (!sl_profile_append(&profile, "(allow ipc*)")) goto fail;
+  if (!sl_profile_append(&profile, "(allow signal)")) goto fail;
+
+  if (!sl_profile_append(&profile, "(allow file-read*)")) goto fail;
+
+  sl_for(it, opts->read.num_dirs) {
+    if (!sl_profile_append_subpath_resolved(&profile, "allow file-read*", opts->read.dirs[it])) {
+      goto fail;
+    }
+  }
+
+  sl_for(it, opts->write.num_dirs) {
+    if (!sl_profile_append_subpath_resolved(&profile, "allow file-write*", opts->write.dirs[it])) {
+      goto fail;
+    }
+  }
+
+  if (!sl_profile_append_subpath(&profile, "allow file-write*", "/dev")) goto fail;
+
+  if (opts->network) {
+    if (!sl_profile_append(&profile, "(allow network*)")) goto fail;
+  }
+
+  return profile.data;
+
+fail:
+  sl_free(profile.data);
+  return SL_NULLPTR;
+}
+
+/* --- public API --------------------------------------------------------- */
+
+sl_ctx_t* sb_create(const sb_opts_t* opts) {
+  if (!opts) return SL_NULLPTR;
+  if (opts->write.num_dirs > 0 && !opts->write.dirs) return SL_NULLPTR;
+  if (opts->read.num_dirs > 0 && !opts->read.dirs) return SL_NULLPTR;
+  if (!sb_load_dylib()) return SL_NULLPTR;
+
+  sl_ctx_t* sb = sl_alloc(sizeof(sl_ctx_t));
+  if (!sb) return SL_NULLPTR;
+
+  sl_child_init(&sb->child);
+  sb->write = (sl_scope_t){
+    .dirs = sl_alloc_n(c8*, opts->write.num_dirs),
+    .num_dirs = opts->write.num_dirs,
+  };
+  sb->read = (sl_scope_t){
+    .dirs = sl_alloc_n(c8*, opts->read.num_dirs),
+    .num_dirs = opts->read.num_dirs,
+  };
+
+  if (sb->write.num_dirs && !sb->write.dirs) {
+    sl_free(sb);
+    return SL_NULLPTR;
+  }
+
+  if (sb->read.num_dirs && !sb->read.dirs) {
+    sl_free((void*)sb->write.dirs);
+    sl_free(sb);
+    return SL_NULLPTR;
+  }
+
+  sl_for(it, sb->write.num_dirs) {
+    sb->write.dirs[it] = sl_cstr_copy(opts->write.dirs[it]);
+    if (!sb->write.dirs[it]) {
+      sb_destroy(sb);
+      return SL_NULLPTR;
+    }
+  }
+
+  sl_for(it, sb->read.num_dirs) {
+    sb->read.dirs[it] = sl_cstr_copy(opts->read.dirs[it]);
+    if (!sb->read.dirs[it]) {
+      sb_destroy(sb);
+      return SL_NULLPTR;
+    }
+  }
+
+  sb->network = opts->network;
+  sb->stdio = opts->stdio;
+  sb->pipe_size = opts->pipe_size;
+  sb->pipe_flags = opts->pipe_flags;
+  sb->inherit_fds = sl_fds_copy(opts->inherit_fds, opts->num_inherit_fds);
+  sb->num_inherit_fds = sb->inherit_fds ? opts->num_inherit_fds : 0;
+  if (opts->num_inherit_fds && !sb->inherit_fds) {
+    sb_destroy(sb);
+    return SL_NULLPTR;
+  }
+
+  u64 start = sl_now_ns();
+  sb->platform.profile = build_profile(opts);
+  if (!sb->platform.profile) {
+    sb_destroy(sb);
+    return SL_NULLPTR;
+  }
+  sb->stats.ruleset_ns = sl_now_ns() - start;
+
+  /* An invalid scope is reported by sb_spawn, not here */
+  start = sl_now_ns();
+  sb->platform.scope_err = sl_validate_ctx_scopes(sb);
+  sb->stats.scope_ns = sl_now_ns() - start;
+
+  return sb;
+}
+
+static sl_err_t sl_platform_check(const sl_ctx_t* sb) {
+  return sb->platform.scope_err;
+}
+
+/* No memfd here; a temp file unlinked on the spot behaves the same for us. */
+static s32 sl_platform_memfd(const c8* name) {
+  const c8* dir = getenv("TMPDIR");
+  c8 path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%s-XXXXXX", dir && dir[0] ? dir : "/tmp", name);
+
+  s32 fd = mkstemp(path);
+  if (fd < 0) return -1;
+  unlink(path);
+  if (fcntl(fd, F_SETFD, FD_CLOEXEC)) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/*
+ * No seals here, and anything still holding the file could shrink it under
+ * a mapping of it, so the output is copied into anonymous memory instead.
+ * It may come up short if it shrank meanwhile; the spare pages are dropped.
+ */
+static s32 sl_platform_output_map(s32 fd, sl_output_t* out) {
+  struct stat st;
+  if (fstat(fd, &st)) return -1;
+  if (!st.st_size) return 0;
+
+  u64 size = (u64)st.st_size;
+  u8* data = (u8*)mmap(SL_NULLPTR, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+  if (data == MAP_FAILED) return -1;
+
+  u64 len = 0;
+  while (len < size) {
+    ssize_t n = pread(fd, data + len, size - len, (off_t)len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) {
+      s32 err = errno;
+      munmap(data, size);
+      errno = err;
+      return -1;
+    }
+    if (n == 0) break;
+    len += (u64)n;
+  }
+
+  u64 page = (u64)getpagesize();
+  u64 keep = (len + page - 1) / page * page;
+  u64 mapped = (size + page - 1) / page * page;
+  if (keep < mapped) munmap(data + keep, mapped - keep);
+  if (!len) return 0;
+
+  *out = (sl_output_t){ .data = data, .len = len };
+  return 0;
+}
+
+/* No pipe2() here, so a fork on another thread can still catch these open. */
+static s32 sl_platform_pipe(s32 fds[2]) {
+  if (pipe(fds)) return -1;
+  if (fcntl(fds[0], F_SETFD, FD_CLOEXEC) || fcntl(fds[1], F_SETFD, FD_CLOEXEC)) {
+    sl_pipe_try_close(fds);
+    return -1;
+  }
+  return 0;
+}
+
+/* No CLONE_PARENT or pidfds here, so nothing a zygote could hand back. */
+static sl_err_t sl_platform_zygote_start(sl_zygote_t* zygote) {
+  (void)zygote;
+  return SL_ERROR_UNSUPPORTED_KERNEL;
+}
+
+/* The same goes for a fork server: its children would not be ours to wait on. */
+static sl_err_t sl_platform_server_start(sl_ctx_t* sb, sl_zygote_t* server) {
+  (void)server;
+  snprintf(sb->error, sizeof(sb->error), "fork servers need CLONE_PARENT (Linux)");
+  return SL_ERROR_UNSUPPORTED_KERNEL;
+}
+
+static sl_spawn_phase_t sl_platform_restrict_self(const sl_ctx_t* sb) {
+  char* sberr = NULL;
+  if (sb_init_fn(sb->platform.profile, 0, NULL, &sberr) != 0) return SL_SPAWN_PHASE_RESTRICT;
+  return SL_SPAWN_PHASE_NONE;
+}
+
+static s32 sl_platform_pidfd_open(pid_t pid) {
+  (void)pid;
+  return -1;
+}
+
+static s32 sl_platform_signal(s32 pidfd, pid_t pid, s32 sig) {
+  (void)pidfd;
+  return kill(pid, sig);
+}
+
+/* No close_range(2) either; closing a free slot is cheap enough to sweep the table. */
+static s32 sl_platform_close_range(u32 from, u32 to) {
+  u32 max = (u32)getdtablesize();
+  for (u32 fd = from; fd <= to && fd < max; fd++) close((s32)fd);
+  return 0;
+}
+
+static sl_err_t sl_platform_spawn(sl_ctx_t* sb, sl_child_t* child, sl_zygote_t* server, sl_pipes_t* pipes, const c8* const* argv, sl_env_t env) {
+  (void)server;
+  const c8* cmd = argv[0];
+
+  s32 status[2] = SL_NULL_PIPE;
+  if (sl_platform_pipe(status)) {
+    snprintf(sb->error, sizeof(sb->error), "pipe: %s", strerror(errno));
+    sl_pipe_try_close(status);
+    sl_pipes_try_close(pipes);
+    return SL_ERROR_PIPE;
+  }
+
+  u64 fork_start = sl_now_ns();
+  pid_t pid = fork();
+  if (pid < 0) {
+    snprintf(sb->error, sizeof(sb->error), "fork: %s", strerror(errno));
+    sl_pipe_try_close(status);
+    sl_pipes_try_close(pipes);
+    return SL_ERROR_FORK;
+  }
+
+  if (pid == 0) {
+    /* --- child --- */
+    sl_spawn_report_t report = { .started = sl_now_ns() };
+    close(status[0]);
+
+    /* wire up stdio */
+    if (sl_pipes_wire(pipes)) {
+      sl_report_abort(status[1], &report, SL_SPAWN_PHASE_STDIO, SL_CHILD_PRE_EXEC_FAILURE);
+    }
+    sl_pipes_try_close(pipes);
+    if (sl_fds_sweep(sb->inherit_fds, sb->num_inherit_fds, status[1])) {
+      sl_report_abort(status[1], &report, SL_SPAWN_PHASE_FDS, SL_CHILD_PRE_EXEC_FAILURE);
+    }
+    report.stdio = sl_now_ns();
+
+    /* apply sandbox */
+    char* sberr = NULL;
+    if (sb_init_fn(sb->platform.profile, 0, NULL, &sberr) != 0) {
+      sl_report_abort(status[1], &report, SL_SPAWN_PHASE_RESTRICT, SL_CHILD_PRE_EXEC_FAILURE);
+    }
+    report.restricted = sl_now_ns();
+
+    report.exec = sl_now_ns();
+    sl_report_write(status[1], &report);
+
+    /* exec */
+    if (env) {
+      execve(cmd, (char* const*)argv, (char* const*)env);
+    }
+
+    if (!env) {
+      extern char** environ;
+      execve(cmd, (char* const*)argv, environ);
+    }
+
+    sl_report_abort(status[1], &report, SL_SPAWN_PHASE_EXEC, SL_CHILD_POST_EXEC_FAILURE);
+  }
+
+  /* --- parent --- */
+  close(status[1]);
+  sl_spawn_report_t report = SL_ZERO;
+  sl_report_read(status[0], &report);
+  close(status[0]);
+
+  sl_stats_record(&sb->stats, &report, fork_start, sl_now_ns());
+  sp_try(sl_spawn_check_report(sb, pid, pipes, &report, cmd));
+  sl_child_adopt(child, pid, pipes);
+  return SL_OK;
+}
+
+/* There is no splice(2) here; forwarding is a read/write loop on the thread. */
+static bool sl_platform_forward(sl_forward_t* fw) {
+  return sl_forward_copy(fw, SL_FORWARD_CHUNK, fw->flags & SL_FORWARD_TEE);
+}
+
+/* No vmsplice(2) either: a gift is copied like anything else. */
+static ssize_t sl_platform_write_stdin(s32 fd, const u8* buf, u64 len, u32 flags) {
+  if (flags & SL_WRITE_NONBLOCK) return sl_write_nowait(fd, buf, len);
+  return write(fd, buf, len);
+}
+
+/* Pipes grow by themselves here. */
+static void sl_platform_pipe_grow(s32 fd, u64 size) {
+  (void)fd;
+  (void)size;
+}
+
+/* --- loop --------------------------------------------------------------- */
+
+/* No io_uring here; asking for it explicitly fails. */
+static bool sl_platform_loop_open(sl_loop_t* loop, sl_loop_backend_t backend) {
+  if (backend == SL_LOOP_BACKEND_IO_URING) {
+    errno = ENOSYS;
+    return false;
+  }
+
+  loop->fd = kqueue();
+  if (loop->fd >= 0 && fcntl(loop->fd, F_SETFD, FD_CLOEXEC)) {
+    close(loop->fd);
+    loop->fd = -1;
+  }
+  return loop->fd >= 0;
+}
+
+static void sl_platform_loop_close(sl_loop_t* loop) {
+  if (loop->fd >= 0) close(loop->fd);
+}
+
+/* kqueue watches the pid itself, so exits never need a fallback here. */
+static bool sl_platform_loop_watch(sl_loop_t* loop, sl_loop_watch_t watch, const sl_child_t* child, u64 token) {
+  struct kevent change;
+  if (watch == SL_LOOP_WATCH_EXIT) {
+    EV_SET(&change, child->pid, EVFILT_PROC, EV_ADD, NOTE_EXIT, 0, (void*)(uintptr_t)token);
+  }
+  if (watch != SL_LOOP_WATCH_EXIT) {
+    EV_SET(&change, sl_loop_child_fd(child, watch), EVFILT_READ, EV_ADD, 0, 0, (void*)(uintptr_t)token);
+  }
+  return kevent(loop->fd, &change, 1, SL_NULLPTR, 0, SL_NULLPTR) == 0;
+}
+
+static void sl_platform_loop_unwatch(sl_loop_t* loop, sl_loop_watch_t watch, const sl_child_t* child, u64 token) {
+  (void)token;
+  struct kevent change;
+  if (watch == SL_LOOP_WATCH_EXIT) {
+    EV_SET(&change, child->pid, EVFILT_PROC, EV_DELETE, 0, 0, SL_NULLPTR);
+  }
+  if (watch != SL_LOOP_WATCH_EXIT) {
+    EV_SET(&change, sl_loop_child_fd(child, watch), EVFILT_READ, EV_DELETE, 0, 0, SL_NULLPTR);
+  }
+  kevent(loop->fd, &change, 1, SL_NULLPTR, 0, SL_NULLPTR);
+}
+
+static bool sl_platform_loop_commit(sl_loop_t* loop) {
+  (void)loop;
+  return true;
+}
+
+static s32 sl_platform_loop_wait(sl_loop_t* loop, sl_loop_ready_t* ready, u32 max, s32 timeout_ms) {
+  struct kevent events[SL_LOOP_MAX_READY];
+  struct timespec timeout = { .tv_sec = timeout_ms / 1000, .tv_nsec = (long)(timeout_ms % 1000) * 1000000 };
+  s32 n = kevent(loop->fd, SL_NULLPTR, 0, events, (s32)(max < SL_LOOP_MAX_READY ? max : SL_LOOP_MAX_READY),
+    timeout_ms < 0 ? SL_NULLPTR : &timeout);
+  sl_for(it, (n > 0 ? (u32)n : 0)) { ready[it] = (sl_loop_ready_t){ .token = (u64)(uintptr_t)events[it].udata }; }
+  return n;
+}
+
+void sb_destroy(sl_ctx_t* sb) {
+  if (!sb || sb->destroyed) return;
+  sb->destroyed = 1;
+
+  sl_child_release(&sb->child);
+  for (u32 i = 0; i < sb->write.num_dirs; i++)
+    sl_free((void*)sb->write.dirs[i]);
+  sl_free((void*)sb->write.dirs);
+  for (u32 i = 0; i < sb->read.num_dirs; i++)
+    sl_free((void*)sb->read.dirs[i]);
+  sl_free((void*)sb->read.dirs);
+  sl_free((void*)sb->platform.profile);
+  sl_free(sb->inherit_fds);
+  sl_free(sb);
+}
+
+#endif
+
+/* --- capabilities ------------------------------------------------------- */
+
+static pthread_once_t sl_caps_once = PTHREAD_ONCE_INIT;
+
+static void sl_caps_init(void) {
+  sl_probe_capabilities(&sl_rt.caps);
+}
+
+const sl_caps_t* sl_capabilities(void) {
+  pthread_once(&sl_caps_once, sl_caps_init);
+  return &sl_rt.caps;
+}
+
+/* --- runtime ------------------------------------------------------------ */
+
+sl_err_t sb_runtime_init(const sb_runtime_opts_t* opts) {
+  /* Probed here so the zygote inherits the answers rather than re-probing. */
+  sl_capabilities();
+  if (!opts || !opts->zygote) return SL_OK;
+
+  pthread_mutex_lock(&sl_rt.zygote.lock);
+  sl_err_t err = sl_rt.zygote.fd >= 0 ? SL_OK : sl_platform_zygote_start(&sl_rt.zygote);
+  pthread_mutex_unlock(&sl_rt.zygote.lock);
+  return err;
+}
+
+/* Children already spawned through the zygote are unaffected. */
+void sb_runtime_shutdown(void) {
+  pthread_mutex_lock(&sl_rt.zygote.lock);
+  if (sl_rt.zygote.fd >= 0) close(sl_rt.zygote.fd);
+  if (sl_rt.zygote.pid > 0) {
+    int status;
+    while (waitpid(sl_rt.zygote.pid, &status, 0) < 0 && errno == EINTR) {}
+  }
+  sl_rt.zygote.fd = -1;
+  sl_rt.zygote.pid = -1;
+  pthread_mutex_unlock(&sl_rt.zygote.lock);
+}
+
+/* --- children ----------------------------------------------------------- */
+
+void sl_child_init(sl_child_t* child) {
+  *child = (sl_child_t){
+    .pid = -1,
+    .pidfd = -1,
+    .stdin_fd = -1,
+    .stdout_fd = -1,
+    .stderr_fd = -1,
+  };
+}
+
+void sl_child_adopt(sl_child_t* child, pid_t pid, sl_pipes_t* pipes) {
+  if (pipes->in[0] >= 0) close(pipes->in[0]);
+  if (pipes->out[1] >= 0) close(pipes->out[1]);
+  if (pipes->err[1] >= 0) close(pipes->err[1]);
+
+  child->pid = pid;
+  child->stdin_fd = pipes->in[1];
+  child->stdout_fd = pipes->out[0];
+  child->stderr_fd = pipes->err[0];
+  child->exited = 0;
+}
+
+void sl_child_release(sl_child_t* child) {
+  if (child->pid > 0 && !child->exited) {
+    sl_platform_signal(child->pidfd, child->pid, SIGKILL);
+    int status;
+    waitpid(child->pid, &status, 0);
+    sl_child_reap(child, status);
+  }
+
+  sl_for(it, 2) {
+    if (child->forward[it]) sl_forward_stop(child->forward[it]);
+    child->forward[it] = SL_NULLPTR;
+  }
+  if (child->loop) sb_loop_remove_child(child->loop, child);
+
+  if (child->pidfd >= 0) close(child->pidfd);
+  if (child->stdin_fd >= 0) close(child->stdin_fd);
+  if (child->stdout_fd >= 0) close(child->stdout_fd);
+  if (child->stderr_fd >= 0) close(child->stderr_fd);
+}
+
+/* Forwarders still running must not signal the pid once it is free for reuse. */
+static s32 sl_child_reap(sl_child_t* child, int status) {
+  sl_for(it, 2) {
+    if (child->forward[it]) __atomic_store_n(&child->forward[it]->reaped, true, __ATOMIC_RELEASE);
+  }
+  child->exited = 1;
+  child->exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+  return child->exit_code;
+}
+
+/* Async-signal-safe; the spawn children call it between fork and exec. */
+u64 sl_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000000 + (u64)ts.tv_nsec;
+}
+
+static u64 sl_now_ms(void) {
+  return sl_now_ns() / 1000000;
+}
+
+/* A stamp the child never reached (it died first) reads as zero. */
+static u64 sl_elapsed(u64 from, u64 to) {
+  return from && to > from ? to - from : 0;
+}
+
+void sl_stats_record(sl_stats_t* stats, const sl_spawn_report_t* report, u64 fork_start, u64 exec_seen) {
+  stats->fork_ns = sl_elapsed(fork_start, report->started);
+  stats->setup_ns = sl_elapsed(report->started, report->stdio);
+  stats->restrict_ns = sl_elapsed(report->stdio, report->restricted);
+  stats->exec_ns = sl_elapsed(report->exec, exec_seen);
+}
+
+/*
+ * A child that reported a failed phase has already exited; reap it and turn
+ * the report into the error sb_spawn returns. Consumes the pipes on failure.
+ */
+sl_err_t sl_spawn_check_report(sl_ctx_t* sb, pid_t pid, sl_pipes_t* pipes, const sl_spawn_report_t* report, const c8* cmd) {
+  if (report->phase == SL_SPAWN_PHASE_NONE) return SL_OK;
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+  sl_pipes_try_close(pipes);
+
+  const c8* reason = strerror(report->err);
+  switch (report->phase) {
+  case SL_SPAWN_PHASE_STDIO:
+    snprintf(sb->error, sizeof(sb->error), "dup2: %s", reason);
+    return SL_ERROR_PIPE;
+  case SL_SPAWN_PHASE_FDS:
+    snprintf(sb->error, sizeof(sb->error), "close fds: %s", reason);
+    return SL_ERROR_PIPE;
+  case SL_SPAWN_PHASE_NO_NEW_PRIVS:
+    snprintf(sb->error, sizeof(sb->error), "prctl(NO_NEW_PRIVS): %s", reason);
+    return SL_ERROR_RESTRICT;
+  case SL_SPAWN_PHASE_RESTRICT:
+    snprintf(sb->error, sizeof(sb->error), "restrict: %s", reason);
+    return SL_ERROR_RESTRICT;
+  }
+
+  snprintf(sb->error, sizeof(sb->error), "execve(%s): %s", cmd, reason);
+  return SL_ERROR_EXEC;
+}
+
+static sl_err_t sl_stdio_open(sl_ctx_t* sb, sl_stdio_stream_t stream, s32 fileno, s32 fds[2]) {
+  s32 child_end = fileno == STDIN_FILENO ? 0 : 1;
+
+  switch (stream.mode) {
+  case SL_STDIO_PIPE: {
+    if (sl_platform_pipe(fds)) {
+      snprintf(sb->error, sizeof(sb->error), "pipe: %s", strerror(errno));
+      return SL_ERROR_PIPE;
+    }
+    if (sb->pipe_size) sl_platform_pipe_grow(fds[0], sb->pipe_size);
+    if (!(sb->pipe_flags & SL_PIPE_NONBLOCK)) return SL_OK;
+
+    s32 parent_end = fds[1 - child_end];
+    s32 flags = fcntl(parent_end, F_GETFL);
+    if (flags < 0 || fcntl(parent_end, F_SETFL, flags | O_NONBLOCK)) {
+      snprintf(sb->error, sizeof(sb->error), "fcntl(O_NONBLOCK): %s", strerror(errno));
+      return SL_ERROR_PIPE;
+    }
+    return SL_OK;
+  }
+  case SL_STDIO_INHERIT: {
+    return SL_OK;
+  }
+  case SL_STDIO_NULL: {
+    fds[child_end] = open("/dev/null", (fileno == STDIN_FILENO ? O_RDONLY : O_WRONLY) | O_CLOEXEC);
+    if (fds[child_end] < 0) {
+      snprintf(sb->error, sizeof(sb->error), "open(/dev/null): %s", strerror(errno));
+      return SL_ERROR_PIPE;
+    }
+    return SL_OK;
+  }
+  case SL_STDIO_FD: {
+    /* Above 2 so wiring one stream can't clobber another's source. */
+    fds[child_end] = stream.fd < 0 ? -1 : fcntl(stream.fd, F_DUPFD_CLOEXEC, 3);
+    if (fds[child_end] < 0) {
+      snprintf(sb->error, sizeof(sb->error), "stdio fd %d: %s", stream.fd, strerror(stream.fd < 0 ? EBADF : errno));
+      return SL_ERROR_INVALID_STDIO;
+    }
+    return SL_OK;
+  }
+  case SL_STDIO_MERGE: {
+    if (fileno == STDERR_FILENO) return SL_OK;
+    break;
+  }
+  case SL_STDIO_MEMFD: {
+    if (fileno == STDIN_FILENO) break;
+
+    /* Both ends are the same file: the parent keeps one, the child gets a dup. */
+    fds[0] = sl_platform_memfd(fileno == STDOUT_FILENO ? "stevelock-stdout" : "stevelock-stderr");
+    fds[1] = fds[0] < 0 ? -1 : fcntl(fds[0], F_DUPFD_CLOEXEC, 3);
+    if (fds[1] < 0) {
+      snprintf(sb->error, sizeof(sb->error), "memfd: %s", strerror(errno));
+      return SL_ERROR_PIPE;
+    }
+    return SL_OK;
+  }
+  }
+
+  snprintf(sb->error, sizeof(sb->error), "invalid stdio mode %d for fd %d", stream.mode, fileno);
+  return SL_ERROR_INVALID_STDIO;
+}
+
+static sl_err_t sl_pipes_open(sl_ctx_t* sb, const sl_stdio_t* stdio, sl_pipes_t* pipes) {
+  *pipes = (sl_pipes_t)SL_NULL_PIPES;
+  pipes->merge_err = stdio->err.mode == SL_STDIO_MERGE;
+
+  sl_err_t err = sl_stdio_open(sb, stdio->in, STDIN_FILENO, pipes->in);
+  if (!err) err = sl_stdio_open(sb, stdio->out, STDOUT_FILENO, pipes->out);
+  if (!err) err = sl_stdio_open(sb, stdio->err, STDERR_FILENO, pipes->err);
+  if (err) {
+    sl_pipes_try_close(pipes);
+    *pipes = (sl_pipes_t)SL_NULL_PIPES;
+  }
+  return err;
+}
+
+static void sl_argv_fill(const c8** argv, const c8* cmd, const c8* const* args, u32 num_args) {
+  argv[0] = cmd;
+  sl_for(it, num_args) { argv[it + 1] = args[it]; }
+  argv[num_args + 1] = SL_NULLPTR;
+}
+
+sl_err_t sl_spawn(sl_ctx_t* sb, sl_child_t* child, sl_zygote_t* server, const c8* cmd, const c8* const* args, u32 num_args, sl_env_t env) {
+  sp_try(sl_platform_check(sb));
+  sb->error[0] = 0;
+  u64 start = sl_now_ns();
+
+  const c8** argv = sl_alloc_n(const c8*, num_args + 2);
+  if (!argv) {
+    snprintf(sb->error, sizeof(sb->error), "alloc argv failed");
+    return SL_ERROR;
+  }
+
+  sl_pipes_t pipes;
+  sl_err_t err = sl_pipes_open(sb, &sb->stdio, &pipes);
+  sb->stats.pipes_ns = sl_now_ns() - start;
+  if (!err) {
+    sl_argv_fill(argv, cmd, args, num_args);
+    err = sl_platform_spawn(sb, child, server, &pipes, argv, env);
+  }
+
+  sl_free((void*)argv);
+  if (!err) {
+    sb->stats.spawn_ns = sl_now_ns() - start;
+    sb->stats.num_spawns++;
+  }
+  return err;
+}
+
+static void sl_ctx_take_child_error(sl_ctx_t* sb) {
+  snprintf(sb->error, sizeof(sb->error), "%s", sb->child.error);
+}
+
+sl_err_t sb_spawn(sl_ctx_t* sb, const c8* cmd, const c8* const* args, u32 num_args, sl_env_t env) {
+  if (!sb) return SL_ERROR_INVALID_CONTEXT;
+  if (!cmd) return SL_ERROR_INVALID_COMMAND;
+  if (num_args && !args) return SL_ERROR_INVALID_COMMAND;
+  if (sb->child.pid != -1) {
+    snprintf(sb->error, sizeof(sb->error), "already spawned");
+    return SL_ERROR;
+  }
+
+  return sl_spawn(sb, &sb->child, SL_NULLPTR, cmd, args, num_args, env);
+}
+
+/*
+ * The callback needs its own copy of our memory, so this is a real fork()
+ * rather than the vfork trampoline, and the report comes back over a pipe.
+ * With no exec to close descriptors, the sweep runs after the policy is
+ * applied, taking the ruleset with it, and the child closes its end of the
+ * status pipe itself. Host stdio is flushed first so the child can't emit a
+ * second copy of what was buffered; the child flushes its own on the way out.
+ */
+static sl_err_t sl_spawn_fn(sl_ctx_t* sb, sl_child_t* child, sl_pipes_t* pipes, sl_spawn_fn_t fn, void* arg) {
+  s32 status[2] = SL_NULL_PIPE;
+  if (sl_platform_pipe(status)) {
+    snprintf(sb->error, sizeof(sb->error), "pipe: %s", strerror(errno));
+    sl_pipes_try_close(pipes);
+    return SL_ERROR_PIPE;
+  }
+
+  fflush(SL_NULLPTR);
+  u64 fork_start = sl_now_ns();
+  pid_t pid = fork();
+  if (pid < 0) {
+    snprintf(sb->error, sizeof(sb->error), "fork: %s", strerror(errno));
+    sl_pipe_try_close(status);
+    sl_pipes_try_close(pipes);
+    return SL_ERROR_FORK;
+  }
+
+  if (pid == 0) {
+    sl_spawn_report_t report = { .started = sl_now_ns() };
+    close(status[0]);
+
+    if (sl_pipes_wire(pipes)) {
+      sl_report_abort(status[1], &report, SL_SPAWN_PHASE_STDIO, SL_CHILD_PRE_EXEC_FAILURE);
+    }
+    sl_pipes_try_close(pipes);
+    report.stdio = sl_now_ns();
+
+    sl_spawn_phase_t phase = sl_platform_restrict_self(sb);
+    if (phase) {
+      sl_report_abort(status[1], &report, phase, SL_CHILD_PRE_EXEC_FAILURE);
+    }
+    report.restricted = sl_now_ns();
+
+    if (sl_fds_sweep(sb->inherit_fds, sb->num_inherit_fds, status[1])) {
+      sl_report_abort(status[1], &report, SL_SPAWN_PHASE_FDS, SL_CHILD_PRE_EXEC_FAILURE);
+    }
+
+    report.exec = sl_now_ns();
+    sl_report_write(status[1], &report);
+    close(status[1]);
+
+    s32 code = fn(arg);
+    fflush(SL_NULLPTR);
+    _exit(code);
+  }
+
+  close(status[1]);
+  sl_spawn_report_t report = SL_ZERO;
+  sl_report_read(status[0], &report);
+  close(status[0]);
+
+  sl_stats_record(&sb->stats, &report, fork_start, sl_now_ns());
+  sp_try(sl_spawn_check_report(sb, pid, pipes, &report, "callback"));
+  sl_child_adopt(child, pid, pipes);
+  child->pidfd = sl_platform_pidfd_open(pid);
+  return SL_OK;
+}
+
+sl_err_t sb_spawn_fn(sl_ctx_t* sb, sl_spawn_fn_t fn, void* arg) {
   if (!sb) return SL_ERROR_INVALID_CONTEXT;
-  if (!cmd) return SL_ERROR_INVALID_COMMAND;
-  if (num_args && !args) return SL_ERROR_INVALID_COMMAND;
-  if (sb->pid != -1) {
+  if (!fn) return SL_ERROR_INVALID_COMMAND;
+  if (sb->child.pid != -1) {
     snprintf(sb->error, sizeof(sb->error), "already spawned");
     return SL_ERROR;
   }
 
-  sp_try(sl_validate_ctx_scopes(sb));
+  sp_try(sl_platform_check(sb));
+  sb->error[0] = 0;
+  u64 start = sl_now_ns();
 
-  s32 ruleset = SL_ZERO;
-  sp_try(build_ruleset(sb, &ruleset));
+  sl_pipes_t pipes;
+  sp_try(sl_pipes_open(sb, &sb->stdio, &pipes));
+  sb->stats.pipes_ns = sl_now_ns() - start;
+  sp_try(sl_spawn_fn(sb, &sb->child, &pipes, fn, arg));
 
-  sl_pipes_t pipes = SL_NULL_PIPES;
-  if (pipe(pipes.in) || pipe(pipes.out) || pipe(pipes.err)) {
-    snprintf(sb->error, sizeof(sb->error), "pipe: %s", strerror(errno));
-    sl_pipes_try_close(&pipes);
-    close(ruleset);
-    return SL_ERROR_PIPE;
-  }
+  sb->stats.spawn_ns = sl_now_ns() - start;
+  sb->stats.num_spawns++;
+  return SL_OK;
+}
 
-  const c8** argv = sl_alloc_n(const c8*, num_args + 2);
-  if (!argv) {
-    snprintf(sb->error, sizeof(sb->error), "alloc argv failed");
-    sl_pipes_try_close(&pipes);
-    close(ruleset);
-    return SL_ERROR;
+pid_t sb_pid(const sl_ctx_t* sb) { return sb ? sb->child.pid : -1; }
+int sb_stdin_fd(const sl_ctx_t* sb) { return sb ? sb->child.stdin_fd : -1; }
+int sb_stdout_fd(const sl_ctx_t* sb) { return sb ? sb->child.stdout_fd : -1; }
+int sb_stderr_fd(const sl_ctx_t* sb) { return sb ? sb->child.stderr_fd : -1; }
+
+int sb_wait(sl_ctx_t* sb) {
+  if (!sb) return -1;
+
+  int code = sb_child_wait(&sb->child);
+  if (code < 0 && sb->child.error[0]) {
+    sl_ctx_take_child_error(sb);
   }
+  return code;
+}
 
-  argv[0] = cmd;
-  sl_for(it, num_args) { argv[it + 1] = args[it]; }
-  argv[num_args + 1] = SL_NULLPTR;
+int sb_pidfd(const sl_ctx_t* sb) { return sb ? sb->child.pidfd : -1; }
 
-  pid_t pid = fork();
+int sb_try_wait(sl_ctx_t* sb) {
+  if (!sb) return -1;
 
-  if (sl_is_parent(pid)) {
-    close(pipes.in[0]);
-    close(pipes.out[1]);
-    close(pipes.err[1]);
-    close(ruleset);
+  int code = sb_child_try_wait(&sb->child);
+  if (code == -1 && sb->child.error[0]) {
+    sl_ctx_take_child_error(sb);
+  }
+  return code;
+}
 
-    sb->pid = pid;
-    sb->stdin_fd = pipes.in[1];
-    sb->stdout_fd = pipes.out[0];
-    sb->stderr_fd = pipes.err[0];
-    sb->exited = 0;
+int sb_wait_timeout(sl_ctx_t* sb, s32 ms) {
+  if (!sb) return -1;
 
-    sl_free((void*)argv);
-    return SL_OK;
+  int code = sb_child_wait_timeout(&sb->child, ms);
+  if (code == -1 && sb->child.error[0]) {
+    sl_ctx_take_child_error(sb);
   }
+  return code;
+}
 
-  if (sl_is_child(pid)) {
-    dup2(pipes.in[0], STDIN_FILENO);
-    dup2(pipes.out[1], STDOUT_FILENO);
-    dup2(pipes.err[1], STDERR_FILENO);
-    sl_pipes_try_close(&pipes);
+int sb_kill(sl_ctx_t* sb, int sig) {
+  if (!sb) return -1;
 
-    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0)) {
-      fprintf(stderr, "prctl(NO_NEW_PRIVS): %s\n", strerror(errno));
-      sl_child_fail(SL_CHILD_PRE_EXEC_FAILURE);
-    }
+  int err = sb_child_kill(&sb->child, sig);
+  if (err && sb->child.error[0]) {
+    sl_ctx_take_child_error(sb);
+  }
+  return err;
+}
 
-    if (landlock_restrict_self(ruleset, 0)) {
-      fprintf(stderr, "landlock_restrict_self: %s\n", strerror(errno));
-      sl_child_fail(SL_CHILD_PRE_EXEC_FAILURE);
-    }
+const c8* sb_error(const sl_ctx_t* sb) {
+  if (!sb) return "null sandbox";
+  return sb->error[0] ? sb->error : SL_NULLPTR;
+}
 
-    close(ruleset);
+const sl_stats_t* sb_stats(const sl_ctx_t* sb) {
+  return sb ? &sb->stats : SL_NULLPTR;
+}
 
-    if (env) {
-      execve(cmd, (char* const*)argv, (char* const*)env);
-    }
+sl_err_t sb_forward(sl_ctx_t* sb, sl_stream_t stream, s32 dest_fd, u32 flags) {
+  if (!sb) return SL_ERROR_INVALID_CONTEXT;
 
-    if (!env) {
-      extern char** environ;
-      execve(cmd, (char* const*)argv, environ);
-    }
+  sl_err_t err = sb_child_forward(&sb->child, stream, dest_fd, flags);
+  if (err) sl_ctx_take_child_error(sb);
+  return err;
+}
 
-    sl_child_fail(SL_CHILD_POST_EXEC_FAILURE);
-  }
+sl_err_t sb_forward_wait(sl_ctx_t* sb, sl_stream_t stream, sl_forward_result_t* out) {
+  if (!sb) return SL_ERROR_INVALID_CONTEXT;
 
-  sl_pipes_try_close(&pipes);
-  close(ruleset);
-  sl_free((void*)argv);
-  snprintf(sb->error, sizeof(sb->error), "fork: %s", strerror(errno));
-  return SL_ERROR_FORK;
+  sl_err_t err = sb_child_forward_wait(&sb->child, stream, out);
+  if (err) sl_ctx_take_child_error(sb);
+  return err;
 }
 
-pid_t sb_pid(const sl_ctx_t* sb) { return sb ? sb->pid : -1; }
-int sb_stdin_fd(const sl_ctx_t* sb) { return sb ? sb->stdin_fd : -1; }
-int sb_stdout_fd(const sl_ctx_t* sb) { return sb ? sb->stdout_fd : -1; }
-int sb_stderr_fd(const sl_ctx_t* sb) { return sb ? sb->stderr_fd : -1; }
+sl_err_t sb_capture(sl_ctx_t* sb, sl_stream_t stream, const sl_capture_opts_t* opts) {
+  if (!sb) return SL_ERROR_INVALID_CONTEXT;
 
-int sb_wait(sl_ctx_t* sb) {
-  if (!sb || sb->pid < 0) return -1;
-  if (sb->exited) return sb->exit_code;
+  sl_err_t err = sb_child_capture(&sb->child, stream, opts);
+  if (err) sl_ctx_take_child_error(sb);
+  return err;
+}
 
-  int status;
-  if (waitpid(sb->pid, &status, 0) < 0) {
-    snprintf(sb->error, sizeof(sb->error), "waitpid: %s", strerror(errno));
-    return -1;
-  }
+sl_err_t sb_capture_wait(sl_ctx_t* sb, sl_stream_t stream, sl_capture_t* out) {
+  if (!sb) return SL_ERROR_INVALID_CONTEXT;
 
-  sb->exited = 1;
-  sb->exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
-  return sb->exit_code;
+  sl_err_t err = sb_child_capture_wait(&sb->child, stream, out);
+  if (err) sl_ctx_take_child_error(sb);
+  return err;
 }
 
-int sb_kill(sl_ctx_t* sb, int sig) {
-  if (!sb || sb->pid < 0 || sb->exited) return -1;
-  if (kill(sb->pid, sig) < 0) {
-    snprintf(sb->error, sizeof(sb->error), "kill: %s", strerror(errno));
-    return -1;
-  }
-  return 0;
+sl_err_t sb_output_map(sl_ctx_t* sb, sl_stream_t stream, sl_output_t* out) {
+  if (!sb) return SL_ERROR_INVALID_CONTEXT;
+
+  sl_err_t err = sb_child_output_map(&sb->child, stream, out);
+  if (err) sl_ctx_take_child_error(sb);
+  return err;
 }
 
-void sb_destroy(sl_ctx_t* sb) {
-  if (!sb || sb->destroyed) return;
-  sb->destroyed = 1;
+s64 sb_write_stdin(sl_ctx_t* sb, const void* buf, u64 len, u32 flags) {
+  if (!sb) return -1;
 
-  if (sb->pid > 0 && !sb->exited) {
-    kill(sb->pid, SIGKILL);
-    int status;
-    waitpid(sb->pid, &status, 0);
-  }
+  s64 n = sb_child_write_stdin(&sb->child, buf, len, flags);
+  if (n < 0) sl_ctx_take_child_error(sb);
+  return n;
+}
 
-  if (sb->stdin_fd >= 0) close(sb->stdin_fd);
-  if (sb->stdout_fd >= 0) close(sb->stdout_fd);
-  if (sb->stderr_fd >= 0) close(sb->stderr_fd);
-  for (u32 i = 0; i < sb->write.num_dirs; i++)
-    sl_free((void*)sb->write.dirs[i]);
-  sl_free((void*)sb->write.dirs);
-  for (u32 i = 0; i < sb->read.num_dirs; i++)
-    sl_free((void*)sb->read.dirs[i]);
-  sl_free((void*)sb->read.dirs);
-  sl_free(sb);
+sl_err_t sb_close_stdin(sl_ctx_t* sb) {
+  if (!sb) return SL_ERROR_INVALID_CONTEXT;
+
+  sl_err_t err = sb_child_close_stdin(&sb->child);
+  if (err) sl_ctx_take_child_error(sb);
+  return err;
 }
 
-const c8* sb_error(const sl_ctx_t* sb) {
-  if (!sb) return "null sandbox";
-  return sb->error[0] ? sb->error : SL_NULLPTR;
+sl_err_t sb_spawn_child(sl_ctx_t* sb, const c8* cmd, const c8* const* args, u32 num_args, sl_env_t env, sl_child_t** out) {
+  if (!sb) return SL_ERROR_INVALID_CONTEXT;
+  if (!cmd) return SL_ERROR_INVALID_COMMAND;
+  if (num_args && !args) return SL_ERROR_INVALID_COMMAND;
+  if (!out) return SL_ERROR;
+  *out = SL_NULLPTR;
+
+  sl_child_t* child = sl_alloc_t(sl_child_t);
+  if (!child) {
+    snprintf(sb->error, sizeof(sb->error), "alloc child failed");
+    return SL_ERROR;
+  }
+  sl_child_init(child);
+
+  sl_err_t err = sl_spawn(sb, child, SL_NULLPTR, cmd, args, num_args, env);
+  if (err) {
+    sl_free(child);
+    return err;
+  }
+
+  *out = child;
+  return SL_OK;
 }
 
-#endif
+/*
+ * All-or-nothing: every pipe is opened up front and one argv buffer is reused
+ * for each spawn. If any child fails to start, the ones already running are
+ * killed and reaped, and nothing is written to `out`.
+ */
+sl_err_t sb_spawn_many(sl_ctx_t* sb, const sb_spawn_spec_t* specs, u32 num_specs, sl_child_t** out) {
+  if (!sb) return SL_ERROR_INVALID_CONTEXT;
+  if (num_specs && (!specs || !out)) return SL_ERROR;
 
-#if defined(SL_MACOS)
+  u32 max_args = 0;
+  sl_for(it, num_specs) {
+    if (!specs[it].cmd) return SL_ERROR_INVALID_COMMAND;
+    if (specs[it].num_args && !specs[it].args) return SL_ERROR_INVALID_COMMAND;
+    if (specs[it].num_args > max_args) max_args = specs[it].num_args;
+  }
+  if (!num_specs) return SL_OK;
+
+  sp_try(sl_platform_check(sb));
+  sb->error[0] = 0;
+  u64 start = sl_now_ns();
+
+  sl_err_t err = SL_OK;
+  u32 num_spawned = 0;
+  sl_child_t** children = sl_alloc_n(sl_child_t*, num_specs);
+  sl_pipes_t* pipes = sl_alloc_n(sl_pipes_t, num_specs);
+  const c8** argv = sl_alloc_n(const c8*, max_args + 2);
+  if (!children || !pipes || !argv) {
+    snprintf(sb->error, sizeof(sb->error), "alloc spawn batch failed");
+    err = SL_ERROR;
+    goto done;
+  }
 
-#include <dlfcn.h>
-#include <errno.h>
-#include <limits.h>
-#include <signal.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <sys/wait.h>
-#include <unistd.h>
+  sl_for(it, num_specs) { pipes[it] = (sl_pipes_t)SL_NULL_PIPES; }
 
-/* --- private sandbox API ------------------------------------------------ */
+  sl_for(it, num_specs) {
+    children[it] = sl_alloc_t(sl_child_t);
+    if (!children[it]) {
+      snprintf(sb->error, sizeof(sb->error), "alloc child failed");
+      err = SL_ERROR;
+      goto done;
+    }
+    sl_child_init(children[it]);
 
-typedef int (*sandbox_init_fn)(const char* profile, uint64_t flags, const char* const params[], char** errorbuf);
-typedef void (*sandbox_free_error_fn)(char* errorbuf);
+    err = sl_pipes_open(sb, specs[it].stdio ? specs[it].stdio : &sb->stdio, &pipes[it]);
+    if (err) goto done;
+  }
+  sb->stats.pipes_ns = sl_now_ns() - start;
 
-static sandbox_init_fn sb_init_fn;
-static sandbox_free_error_fn sb_free_fn;
+  for (; num_spawned < num_specs; num_spawned++) {
+    const sb_spawn_spec_t* spec = &specs[num_spawned];
+    sl_argv_fill(argv, spec->cmd, spec->args, spec->num_args);
 
-static int sb_load_dylib(void) {
-  static int loaded = -1;
-  if (loaded != -1) return loaded;
+    err = sl_platform_spawn(sb, children[num_spawned], SL_NULLPTR, &pipes[num_spawned], argv, spec->env);
+    if (err) {
+      pipes[num_spawned] = (sl_pipes_t)SL_NULL_PIPES;
+      goto done;
+    }
+  }
 
-  void* lib = dlopen("/usr/lib/system/libsystem_sandbox.dylib", RTLD_LAZY);
-  if (!lib) {
-    loaded = 0;
-    return 0;
+  sl_for(it, num_specs) { out[it] = children[it]; }
+  sb->stats.spawn_ns = sl_now_ns() - start;
+  sb->stats.num_spawns += num_specs;
+
+done:
+  if (err && children) {
+    sl_for(it, num_specs) {
+      if (it >= num_spawned && pipes) sl_pipes_try_close(&pipes[it]);
+      if (children[it]) sb_child_destroy(children[it]);
+    }
   }
 
-  sb_init_fn = (sandbox_init_fn)dlsym(lib, "sandbox_init_with_parameters");
-  sb_free_fn = (sandbox_free_error_fn)dlsym(lib, "sandbox_free_error");
-  loaded = (sb_init_fn && sb_free_fn) ? 1 : 0;
-  return loaded;
+  sl_free((void*)argv);
+  sl_free(pipes);
+  sl_free(children);
+  return err;
 }
 
-/* --- profile generation ------------------------------------------------- */
+/* --- fork server -------------------------------------------------------- */
 
-typedef struct {
-  c8* data;
-  u64 len;
-  u64 cap;
-} sl_profile_builder_t;
+struct sl_server {
+  sl_ctx_t* sb;
+  sl_zygote_t process;
+};
 
-static bool sl_profile_reserve(sl_profile_builder_t* builder, u64 append_len) {
-  if (!builder) {
-    return false;
-  }
+sl_server_t* sb_server_create(sl_ctx_t* sb) {
+  if (!sb || sl_platform_check(sb)) return SL_NULLPTR;
 
-  u64 required = builder->len + append_len + 1;
-  if (required <= builder->cap) {
-    return true;
+  sl_server_t* server = sl_alloc_t(sl_server_t);
+  if (!server) return SL_NULLPTR;
+
+  server->sb = sb;
+  server->process = (sl_zygote_t){ .fd = -1, .pid = -1 };
+  pthread_mutex_init(&server->process.lock, SL_NULLPTR);
+  if (sl_platform_server_start(sb, &server->process)) {
+    pthread_mutex_destroy(&server->process.lock);
+    sl_free(server);
+    return SL_NULLPTR;
   }
+  return server;
+}
 
-  u64 cap = builder->cap;
-  if (!cap) {
-    cap = 4096;
+sl_err_t sb_server_spawn(sl_server_t* server, const c8* cmd, const c8* const* args, u32 num_args, sl_env_t env, sl_child_t** out) {
+  if (!server) return SL_ERROR_INVALID_CONTEXT;
+  if (!cmd) return SL_ERROR_INVALID_COMMAND;
+  if (num_args && !args) return SL_ERROR_INVALID_COMMAND;
+  if (!out) return SL_ERROR;
+  *out = SL_NULLPTR;
+
+  sl_child_t* child = sl_alloc_t(sl_child_t);
+  if (!child) {
+    snprintf(server->sb->error, sizeof(server->sb->error), "alloc child failed");
+    return SL_ERROR;
   }
+  sl_child_init(child);
 
-  while (cap < required) {
-    if (cap > (UINT64_MAX / 2)) {
-      return false;
-    }
-    cap *= 2;
+  sl_err_t err = sl_spawn(server->sb, child, &server->process, cmd, args, num_args, env);
+  if (err) {
+    sl_free(child);
+    return err;
   }
 
-  c8* next = sl_allocator_realloc(sl_rt.gpa, builder->data, cap);
-  if (!next) {
-    return false;
+  *out = child;
+  return SL_OK;
+}
+
+/* Children it spawned are unaffected. */
+void sb_server_destroy(sl_server_t* server) {
+  if (!server) return;
+
+  close(server->process.fd);
+  int status;
+  while (waitpid(server->process.pid, &status, 0) < 0 && errno == EINTR) {}
+  pthread_mutex_destroy(&server->process.lock);
+  sl_free(server);
+}
+
+pid_t sb_child_pid(const sl_child_t* child) { return child ? child->pid : -1; }
+int sb_child_stdin_fd(const sl_child_t* child) { return child ? child->stdin_fd : -1; }
+int sb_child_stdout_fd(const sl_child_t* child) { return child ? child->stdout_fd : -1; }
+int sb_child_stderr_fd(const sl_child_t* child) { return child ? child->stderr_fd : -1; }
+int sb_child_pidfd(const sl_child_t* child) { return child ? child->pidfd : -1; }
+
+int sb_child_wait(sl_child_t* child) {
+  if (!child || child->pid < 0) return -1;
+  if (child->exited) return child->exit_code;
+
+  int status;
+  if (waitpid(child->pid, &status, 0) < 0) {
+    snprintf(child->error, sizeof(child->error), "waitpid: %s", strerror(errno));
+    return -1;
   }
 
-  builder->data = next;
-  builder->cap = cap;
-  return true;
+  return sl_child_reap(child, status);
 }
 
-static bool sl_profile_append_n(sl_profile_builder_t* builder, const c8* value, u64 len) {
-  if (!len) {
-    return true;
+int sb_child_try_wait(sl_child_t* child) {
+  if (!child || child->pid < 0) return -1;
+  if (child->exited) return child->exit_code;
+
+  int status;
+  pid_t pid = waitpid(child->pid, &status, WNOHANG);
+  if (pid < 0) {
+    snprintf(child->error, sizeof(child->error), "waitpid: %s", strerror(errno));
+    return -1;
   }
-  if (!value) {
-    return false;
+  if (pid == 0) return SL_CHILD_RUNNING;
+
+  return sl_child_reap(child, status);
+}
+
+/*
+ * A negative timeout blocks like sb_child_wait(). With a pidfd this is a
+ * single poll(); without one (macOS, kernels before 5.3) it falls back to
+ * polling waitpid with a short backoff.
+ */
+int sb_child_wait_timeout(sl_child_t* child, s32 ms) {
+  if (ms < 0) return sb_child_wait(child);
+
+  int code = sb_child_try_wait(child);
+  if (code != SL_CHILD_RUNNING) return code;
+
+  u64 deadline = sl_now_ms() + (u64)ms;
+  u32 backoff_ms = 1;
+  while (code == SL_CHILD_RUNNING) {
+    u64 now = sl_now_ms();
+    if (now >= deadline) break;
+    s32 remaining = (s32)(deadline - now);
+
+    if (child->pidfd >= 0) {
+      struct pollfd pfd = { .fd = child->pidfd, .events = POLLIN };
+      if (poll(&pfd, 1, remaining) < 0 && errno != EINTR) {
+        snprintf(child->error, sizeof(child->error), "poll: %s", strerror(errno));
+        return -1;
+      }
+    }
+
+    if (child->pidfd < 0) {
+      u32 nap_ms = backoff_ms < (u32)remaining ? backoff_ms : (u32)remaining;
+      struct timespec nap = { .tv_sec = nap_ms / 1000, .tv_nsec = (long)(nap_ms % 1000) * 1000000 };
+      nanosleep(&nap, SL_NULLPTR);
+      if (backoff_ms < 16) backoff_ms *= 2;
+    }
+
+    code = sb_child_try_wait(child);
   }
-  if (!sl_profile_reserve(builder, len)) {
-    return false;
+
+  return code;
+}
+
+int sb_child_kill(sl_child_t* child, int sig) {
+  if (!child || child->pid < 0 || child->exited) return -1;
+  if (sl_platform_signal(child->pidfd, child->pid, sig) < 0) {
+    snprintf(child->error, sizeof(child->error), "kill: %s", strerror(errno));
+    return -1;
   }
+  return 0;
+}
 
-  memcpy(builder->data + builder->len, value, len);
-  builder->len += len;
-  builder->data[builder->len] = 0;
-  return true;
+/* --- forwarding --------------------------------------------------------- */
+
+bool sl_forward_fail(sl_forward_t* fw, const c8* op) {
+  fw->err = errno;
+  fw->op = op;
+  return false;
 }
 
-static bool sl_profile_append(sl_profile_builder_t* builder, const c8* value) {
-  if (!value) {
-    return false;
+/*
+ * A non-blocking destination (the caller's socket, say) that is full says
+ * EAGAIN; wait for room rather than giving up, or the child blocks on a
+ * pipe nobody drains. False once sl_forward_stop() asks us to go.
+ */
+bool sl_forward_wait_dest(sl_forward_t* fw) {
+  struct pollfd pfds[2] = {
+    { .fd = fw->dest, .events = POLLOUT },
+    { .fd = fw->wake[0], .events = POLLIN },
+  };
+  while (poll(pfds, 2, -1) < 0) {
+    if (errno != EINTR) return sl_forward_fail(fw, "poll");
   }
-  return sl_profile_append_n(builder, value, sl_cstr_len(value));
+  return !pfds[1].revents;
 }
 
-static bool sl_profile_append_ch(sl_profile_builder_t* builder, c8 ch) {
-  return sl_profile_append_n(builder, &ch, 1);
+bool sl_forward_reserve(sl_forward_t* fw, u64 len) {
+  if (fw->keep_len + len <= fw->keep_cap) return true;
+
+  u64 cap = fw->keep_cap ? fw->keep_cap : SL_FORWARD_CHUNK;
+  while (cap < fw->keep_len + len) cap *= 2;
+
+  u8* keep = (u8*)sl_allocator_realloc(sl_rt.gpa, fw->keep, cap);
+  if (!keep) {
+    errno = ENOMEM;
+    return sl_forward_fail(fw, "realloc");
+  }
+  fw->keep = keep;
+  fw->keep_cap = cap;
+  return true;
 }
 
-static bool sl_profile_append_escaped_path(sl_profile_builder_t* builder, const c8* path) {
-  if (!path || !path[0]) {
-    return false;
+/* One read() into the head, then the tail ring; counts everything. */
+static bool sl_capture_step(sl_forward_t* fw) {
+  ssize_t n = read(fw->src, fw->scratch, SL_FORWARD_CHUNK);
+  if (n < 0 && (errno == EINTR || errno == EAGAIN)) return true;
+  if (n < 0) return sl_forward_fail(fw, "read");
+  if (n == 0) return false;
+
+  const u8* data = fw->scratch;
+  u64 len = (u64)n;
+  fw->bytes += len;
+
+  u64 head = fw->head_cap - fw->head_len < len ? fw->head_cap - fw->head_len : len;
+  if (head) {
+    memcpy(fw->head + fw->head_len, data, head);
+    fw->head_len += head;
+    data += head;
+    len -= head;
   }
 
-  for (u32 it = 0; path[it]; it++) {
-    c8 ch = path[it];
-    if (ch == '\\' || ch == '"') {
-      if (!sl_profile_append_ch(builder, '\\')) {
-        return false;
-      }
-    }
-    if (!sl_profile_append_ch(builder, ch)) {
-      return false;
+  if (len && fw->tail_cap) {
+    if (len > fw->tail_cap) {
+      data += len - fw->tail_cap;
+      len = fw->tail_cap;
     }
+    u64 first = fw->tail_cap - fw->tail_pos < len ? fw->tail_cap - fw->tail_pos : len;
+    memcpy(fw->tail + fw->tail_pos, data, first);
+    memcpy(fw->tail, data + first, len - first);
+    fw->tail_pos = (fw->tail_pos + len) % fw->tail_cap;
+    fw->tail_len = fw->tail_len + len < fw->tail_cap ? fw->tail_len + len : fw->tail_cap;
   }
 
+  if (fw->quota && fw->bytes > fw->quota && !fw->over_quota) {
+    fw->over_quota = true;
+    if (fw->pid > 0 && !__atomic_load_n(&fw->reaped, __ATOMIC_ACQUIRE)) sl_platform_signal(fw->pidfd, fw->pid, SIGKILL);
+  }
   return true;
 }
 
-static bool sl_profile_append_subpath(sl_profile_builder_t* builder, const c8* action, const c8* path) {
-  if (!action || !path || !path[0]) {
-    return false;
+/* The portable path: one read() of at most `max` bytes, written out in full. */
+bool sl_forward_copy(sl_forward_t* fw, u64 max, bool keep) {
+  if (!fw->scratch) fw->scratch = (u8*)sl_alloc(SL_FORWARD_CHUNK);
+  if (!fw->scratch) {
+    errno = ENOMEM;
+    return sl_forward_fail(fw, "alloc");
   }
 
-  if (!sl_profile_append_ch(builder, '(')) {
-    return false;
-  }
-  if (!sl_profile_append(builder, action)) {
-    return false;
+  ssize_t n = read(fw->src, fw->scratch, max < SL_FORWARD_CHUNK ? max : SL_FORWARD_CHUNK);
+  if (n < 0 && (errno == EINTR || errno == EAGAIN)) return true;
+  if (n < 0) return sl_forward_fail(fw, "read");
+  if (n == 0) return false;
+
+  if (keep) {
+    if (!sl_forward_reserve(fw, (u64)n)) return false;
+    memcpy(fw->keep + fw->keep_len, fw->scratch, (u64)n);
+    fw->keep_len += (u64)n;
   }
-  if (!sl_profile_append(builder, " (subpath \"")) {
-    return false;
+
+  for (ssize_t done = 0; done < n;) {
+    ssize_t w = write(fw->dest, fw->scratch + done, (u64)(n - done));
+    if (w < 0 && errno == EINTR) continue;
+    if (w < 0 && errno == EAGAIN) {
+      if (!sl_forward_wait_dest(fw)) return false;
+      continue;
+    }
+    if (w < 0) return sl_forward_fail(fw, "write");
+    done += w;
+    fw->bytes += (u64)w;
   }
-  if (!sl_profile_append_escaped_path(builder, path)) {
-    return false;
+  return true;
+}
+
+static void* sl_forward_main(void* userdata) {
+  sl_forward_t* fw = (sl_forward_t*)userdata;
+
+  bool more = true;
+  while (more) {
+    struct pollfd pfds[2] = {
+      { .fd = fw->src, .events = POLLIN },
+      { .fd = fw->wake[0], .events = POLLIN },
+    };
+    if (poll(pfds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      sl_forward_fail(fw, "poll");
+      break;
+    }
+    if (pfds[1].revents) break;
+
+    more = fw->dest >= 0 ? sl_platform_forward(fw) : sl_capture_step(fw);
   }
-  if (!sl_profile_append(builder, "\"))")) {
-    return false;
+  return SL_NULLPTR;
+}
+
+static void sl_forward_free(sl_forward_t* fw) {
+  if (fw->src >= 0) close(fw->src);
+  if (fw->dest >= 0) close(fw->dest);
+  if (fw->pidfd >= 0) close(fw->pidfd);
+  sl_pipe_try_close(fw->wake);
+  sl_pipe_try_close(fw->copy);
+  sl_free(fw->keep);
+  sl_free(fw->head);
+  sl_free(fw->tail);
+  sl_free(fw->scratch);
+  sl_free(fw);
+}
+
+/* Stops early, dropping anything not yet forwarded. */
+void sl_forward_stop(sl_forward_t* fw) {
+  c8 byte = 0;
+  while (write(fw->wake[1], &byte, 1) < 0 && errno == EINTR) {}
+  pthread_join(fw->thread, SL_NULLPTR);
+  sl_forward_free(fw);
+}
+
+static sl_forward_t** sl_forward_slot(sl_child_t* child, sl_stream_t stream) {
+  if (stream != SL_STDOUT && stream != SL_STDERR) return SL_NULLPTR;
+  return &child->forward[stream - 1];
+}
+
+static sl_forward_t* sl_forward_new(sl_child_t* child, u32 flags) {
+  sl_forward_t* fw = sl_alloc_t(sl_forward_t);
+  if (!fw) {
+    snprintf(child->error, sizeof(child->error), "failed to allocate forwarder");
+    return SL_NULLPTR;
   }
 
-  return true;
+  *fw = (sl_forward_t){
+    .src = -1,
+    .dest = -1,
+    .wake = SL_NULL_PIPE,
+    .copy = SL_NULL_PIPE,
+    .flags = flags,
+    .splice = true,
+    .pidfd = child->pidfd >= 0 ? fcntl(child->pidfd, F_DUPFD_CLOEXEC, 0) : -1,
+    .pid = child->pid,
+  };
+  return fw;
 }
 
-static bool sl_profile_append_subpath_resolved(sl_profile_builder_t* builder, const c8* action, const c8* path) {
-  if (!sl_profile_append_subpath(builder, action, path)) {
-    return false;
+/*
+ * Takes the parent's end of `stream` away from the child handle and starts
+ * `fw` on it. `fw` is consumed either way.
+ */
+static sl_err_t sl_forward_start(sl_child_t* child, sl_stream_t stream, sl_forward_t* fw) {
+  sl_forward_t** slot = sl_forward_slot(child, stream);
+  s32* src = stream == SL_STDOUT ? &child->stdout_fd : &child->stderr_fd;
+  if (!slot || *slot || *src < 0) {
+    snprintf(child->error, sizeof(child->error), "stream %d is not a pipe the parent owns", (s32)stream);
+    sl_forward_free(fw);
+    return SL_ERROR_INVALID_STDIO;
   }
 
-  c8 resolved[PATH_MAX] = SL_ZERO;
-  if (!realpath(path, resolved)) {
-    return true;
+  if (sl_platform_pipe(fw->wake)) {
+    snprintf(child->error, sizeof(child->error), "pipe: %s", strerror(errno));
+    sl_forward_free(fw);
+    return SL_ERROR_PIPE;
   }
-  if (!strcmp(path, resolved)) {
-    return true;
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, SL_FORWARD_STACK);
+
+  /* An O_NONBLOCK source makes every splice from it non-blocking too. */
+  s32 flags = fcntl(*src, F_GETFL);
+  if (flags >= 0 && (flags & O_NONBLOCK)) fcntl(*src, F_SETFL, flags & ~O_NONBLOCK);
+
+  fw->src = *src;
+  s32 err = pthread_create(&fw->thread, &attr, sl_forward_main, fw);
+  pthread_attr_destroy(&attr);
+  if (err) {
+    fw->src = -1;
+    snprintf(child->error, sizeof(child->error), "pthread_create: %s", strerror(err));
+    sl_forward_free(fw);
+    return SL_ERROR;
   }
 
-  return sl_profile_append_subpath(builder, action, resolved);
+  *src = -1;
+  *slot = fw;
+  return SL_OK;
 }
 
-static c8* build_profile(const sb_opts_t* opts) {
-  if (!opts) {
+/* Joins the forwarder on `stream`; the caller frees what it returns. */
+static sl_forward_t* sl_forward_join(sl_child_t* child, sl_stream_t stream, sl_err_t* result) {
+  sl_forward_t** slot = sl_forward_slot(child, stream);
+  if (!slot || !*slot) {
+    snprintf(child->error, sizeof(child->error), "stream %d is not being forwarded", (s32)stream);
+    *result = SL_ERROR_INVALID_STDIO;
     return SL_NULLPTR;
   }
 
-  sl_profile_builder_t profile = {
-    .data = sl_alloc_n(c8, 4096),
-    .cap = 4096,
-  };
-  if (!profile.data) {
-    return SL_NULLPTR;
+  sl_forward_t* fw = *slot;
+  *slot = SL_NULLPTR;
+  pthread_join(fw->thread, SL_NULLPTR);
+
+  *result = SL_OK;
+  if (fw->op) {
+    snprintf(child->error, sizeof(child->error), "forward: %s: %s", fw->op, strerror(fw->err));
+    *result = SL_ERROR_FORWARD;
   }
-  profile.data[0] = 0;
+  return fw;
+}
 
-  if (!sl_profile_append(&profile, "(version 1)")) goto fail;
-  if (!sl_profile_append(&profile, "(deny default (with no-log))")) goto fail;
-  if (!sl_profile_append(&profile, "(allow process*)")) goto fail;
-  if (!sl_profile_append(&profile, "(allow sysctl-read)")) goto fail;
-  if (!sl_profile_append(&profile, "(allow mach*)")) goto fail;
-  if (!sl_profile_append(&profile, "(allow ipc*)")) goto fail;
-  if (!sl_profile_append(&profile, "(allow signal)")) goto fail;
+/*
+ * Hands the parent's end of `stream` to a forwarder thread that moves
+ * everything the child writes to `dest_fd` until EOF. The pipe is no longer
+ * the caller's: sb_child_stdout_fd()/stderr_fd() read -1 from here on.
+ * `dest_fd` is duplicated, so the caller may close theirs.
+ */
+sl_err_t sb_child_forward(sl_child_t* child, sl_stream_t stream, s32 dest_fd, u32 flags) {
+  if (!child) return SL_ERROR_INVALID_CONTEXT;
 
-  if (!sl_profile_append(&profile, "(allow file-read*)")) goto fail;
+  sl_forward_t* fw = sl_forward_new(child, flags);
+  if (!fw) return SL_ERROR;
 
-  sl_for(it, opts->read.num_dirs) {
-    if (!sl_profile_append_subpath_resolved(&profile, "allow file-read*", opts->read.dirs[it])) {
-      goto fail;
-    }
+  fw->dest = fcntl(dest_fd, F_DUPFD_CLOEXEC, 3);
+  if (fw->dest < 0) {
+    snprintf(child->error, sizeof(child->error), "forward fd %d: %s", dest_fd, strerror(errno));
+    sl_forward_free(fw);
+    return SL_ERROR_INVALID_STDIO;
   }
 
-  sl_for(it, opts->write.num_dirs) {
-    if (!sl_profile_append_subpath_resolved(&profile, "allow file-write*", opts->write.dirs[it])) {
-      goto fail;
-    }
-  }
+  return sl_forward_start(child, stream, fw);
+}
 
-  if (!sl_profile_append_subpath(&profile, "allow file-write*", "/dev")) goto fail;
+/*
+ * Blocks until the forwarder has seen EOF. With SL_FORWARD_TEE, `out->copy`
+ * is everything that went through, owned by the caller (sl_free it).
+ */
+sl_err_t sb_child_forward_wait(sl_child_t* child, sl_stream_t stream, sl_forward_result_t* out) {
+  if (!child) return SL_ERROR_INVALID_CONTEXT;
 
-  if (opts->network) {
-    if (!sl_profile_append(&profile, "(allow network*)")) goto fail;
+  sl_err_t result = SL_OK;
+  sl_forward_t* fw = sl_forward_join(child, stream, &result);
+  if (!fw) return result;
+
+  if (out) {
+    *out = (sl_forward_result_t){ .bytes = fw->bytes, .copy = fw->keep, .copy_len = fw->keep_len };
+    fw->keep = SL_NULLPTR;
   }
+  sl_forward_free(fw);
+  return result;
+}
 
-  return profile.data;
+/*
+ * Drains `stream` on the forwarder thread into memory that never grows past
+ * head + tail bytes: the first `head` bytes, and a ring holding the last
+ * `tail`. Anything in between is only counted. With a quota, the child is
+ * sent SIGKILL as soon as the stream has produced more than that; draining
+ * continues so nothing blocks on a full pipe.
+ */
+sl_err_t sb_child_capture(sl_child_t* child, sl_stream_t stream, const sl_capture_opts_t* opts) {
+  if (!child) return SL_ERROR_INVALID_CONTEXT;
+  if (!opts) return SL_ERROR;
+
+  sl_forward_t* fw = sl_forward_new(child, 0);
+  if (!fw) return SL_ERROR;
+
+  fw->quota = opts->quota;
+  fw->head_cap = opts->head;
+  fw->tail_cap = opts->tail;
+  fw->head = opts->head ? (u8*)sl_alloc(opts->head) : SL_NULLPTR;
+  fw->tail = opts->tail ? (u8*)sl_alloc(opts->tail) : SL_NULLPTR;
+  fw->scratch = (u8*)sl_alloc(SL_FORWARD_CHUNK);
+  if ((opts->head && !fw->head) || (opts->tail && !fw->tail) || !fw->scratch) {
+    snprintf(child->error, sizeof(child->error), "failed to allocate %llu bytes of capture",
+      (unsigned long long)(opts->head + opts->tail + SL_FORWARD_CHUNK));
+    sl_forward_free(fw);
+    return SL_ERROR;
+  }
 
-fail:
-  sl_free(profile.data);
-  return SL_NULLPTR;
+  return sl_forward_start(child, stream, fw);
 }
 
-/* --- public API --------------------------------------------------------- */
+/*
+ * Blocks until the captured stream hits EOF. `out->head` and `out->tail`
+ * belong to the caller (sl_free them); the tail comes back in order.
+ */
+sl_err_t sb_child_capture_wait(sl_child_t* child, sl_stream_t stream, sl_capture_t* out) {
+  if (!child) return SL_ERROR_INVALID_CONTEXT;
+
+  sl_err_t result = SL_OK;
+  sl_forward_t* fw = sl_forward_join(child, stream, &result);
+  if (!fw) return result;
+
+  if (out) {
+    *out = (sl_capture_t){
+      .head = fw->head,
+      .head_len = fw->head_len,
+      .total = fw->bytes,
+      .over_quota = fw->over_quota,
+    };
+    fw->head = SL_NULLPTR;
+
+    /* rotate the ring so the oldest kept byte comes first */
+    u64 start = (fw->tail_pos + fw->tail_cap - fw->tail_len) % (fw->tail_cap ? fw->tail_cap : 1);
+    u8* tail = fw->tail_len ? (u8*)sl_alloc(fw->tail_len) : SL_NULLPTR;
+    if (tail) {
+      u64 first = fw->tail_cap - start < fw->tail_len ? fw->tail_cap - start : fw->tail_len;
+      memcpy(tail, fw->tail + start, first);
+      memcpy(tail + first, fw->tail, fw->tail_len - first);
+      out->tail = tail;
+      out->tail_len = fw->tail_len;
+    }
+  }
+  sl_forward_free(fw);
+  return result;
+}
 
-sl_ctx_t* sb_create(const sb_opts_t* opts) {
-  if (!opts) return SL_NULLPTR;
-  if (opts->write.num_dirs > 0 && !opts->write.dirs) return SL_NULLPTR;
-  if (opts->read.num_dirs > 0 && !opts->read.dirs) return SL_NULLPTR;
-  if (!sb_load_dylib()) return SL_NULLPTR;
+/*
+ * Maps a SL_STDIO_MEMFD stream once the child has exited: no read loop and
+ * no copy (macOS, which can't seal the file, copies it). The mapping is
+ * private and writable (copy-on-write), independent of the child handle,
+ * and released with sb_output_unmap(). Empty output is a NULL `data` with
+ * zero `len`.
+ */
+sl_err_t sb_child_output_map(sl_child_t* child, sl_stream_t stream, sl_output_t* out) {
+  if (!child) return SL_ERROR_INVALID_CONTEXT;
+  if (!out) return SL_ERROR;
+  *out = (sl_output_t)SL_ZERO;
+
+  s32 fd = stream == SL_STDOUT ? child->stdout_fd : stream == SL_STDERR ? child->stderr_fd : -1;
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+    snprintf(child->error, sizeof(child->error), "stream %d is not a memfd", (s32)stream);
+    return SL_ERROR_INVALID_STDIO;
+  }
+  if (!child->exited) {
+    snprintf(child->error, sizeof(child->error), "child is still running");
+    return SL_ERROR;
+  }
 
-  sl_ctx_t* sb = sl_alloc(sizeof(sl_ctx_t));
-  if (!sb) return SL_NULLPTR;
+  if (sl_platform_output_map(fd, out)) {
+    snprintf(child->error, sizeof(child->error), "map output: %s", strerror(errno));
+    return SL_ERROR;
+  }
+  return SL_OK;
+}
 
-  sb->pid = -1;
-  sb->stdin_fd = -1;
-  sb->stdout_fd = -1;
-  sb->stderr_fd = -1;
-  sb->write = (sl_scope_t){
-    .dirs = sl_alloc_n(c8*, opts->write.num_dirs),
-    .num_dirs = opts->write.num_dirs,
-  };
-  sb->read = (sl_scope_t){
-    .dirs = sl_alloc_n(c8*, opts->read.num_dirs),
-    .num_dirs = opts->read.num_dirs,
-  };
+void sb_output_unmap(sl_output_t* output) {
+  if (!output || !output->data) return;
+  munmap(output->data, output->len);
+  *output = (sl_output_t)SL_ZERO;
+}
 
-  if (sb->write.num_dirs && !sb->write.dirs) {
-    sl_free(sb);
-    return SL_NULLPTR;
+/* --- stdin -------------------------------------------------------------- */
+
+/*
+ * A pipe write that can't block, without making the descriptor (which the
+ * caller may share) O_NONBLOCK: once poll() reports room, a pipe takes
+ * PIPE_BUF bytes without waiting. EAGAIN when it is full.
+ */
+static ssize_t sl_write_nowait(s32 fd, const u8* buf, u64 len) {
+  struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+  if (poll(&pfd, 1, 0) == 0) {
+    errno = EAGAIN;
+    return -1;
   }
+  return write(fd, buf, len < PIPE_BUF ? len : PIPE_BUF);
+}
 
-  if (sb->read.num_dirs && !sb->read.dirs) {
-    sl_free((void*)sb->write.dirs);
-    sl_free(sb);
-    return SL_NULLPTR;
+/*
+ * Writes `len` bytes into the child's stdin pipe, waiting for room as the
+ * child reads (that wait is the backpressure). The pipe is first grown
+ * towards the payload, up to SL_STDIN_PIPE_SIZE, so a large write is fewer,
+ * bigger rounds. A child that closed its stdin is an error rather than a
+ * SIGPIPE: the signal is held off for the duration and a SIGPIPE this write
+ * raised is swallowed. Returns the bytes written (short only with
+ * SL_WRITE_NONBLOCK), or -1 (see sb_child_error()).
+ */
+s64 sb_child_write_stdin(sl_child_t* child, const void* buf, u64 len, u32 flags) {
+  if (!child) return -1;
+  if (child->stdin_fd < 0) {
+    snprintf(child->error, sizeof(child->error), "stdin is not a pipe");
+    return -1;
+  }
+  if (len && !buf) {
+    snprintf(child->error, sizeof(child->error), "null buffer");
+    return -1;
   }
 
-  sl_for(it, sb->write.num_dirs) {
-    sb->write.dirs[it] = sl_cstr_copy(opts->write.dirs[it]);
-    if (!sb->write.dirs[it]) {
-      sb_destroy(sb);
-      return SL_NULLPTR;
+  if (len > SL_FORWARD_CHUNK) sl_platform_pipe_grow(child->stdin_fd, len < SL_STDIN_PIPE_SIZE ? len : SL_STDIN_PIPE_SIZE);
+
+  sigset_t sigpipe;
+  sigset_t saved;
+  sigset_t pending;
+  sigemptyset(&sigpipe);
+  sigaddset(&sigpipe, SIGPIPE);
+  sigpending(&pending);
+  bool was_pending = sigismember(&pending, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &sigpipe, &saved);
+
+  const u8* data = (const u8*)buf;
+  u64 done = 0;
+  s32 err = 0;
+  while (done < len) {
+    ssize_t n = sl_platform_write_stdin(child->stdin_fd, data + done, len - done, flags);
+    if (n > 0) {
+      done += (u64)n;
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && errno == EAGAIN && (flags & SL_WRITE_NONBLOCK)) break;
+    if (n < 0 && errno == EAGAIN) {
+      struct pollfd pfd = { .fd = child->stdin_fd, .events = POLLOUT };
+      poll(&pfd, 1, -1);
+      continue;
     }
+    err = n < 0 ? errno : EIO;
+    break;
   }
 
-  sl_for(it, sb->read.num_dirs) {
-    sb->read.dirs[it] = sl_cstr_copy(opts->read.dirs[it]);
-    if (!sb->read.dirs[it]) {
-      sb_destroy(sb);
-      return SL_NULLPTR;
-    }
+  if (err == EPIPE && !was_pending) {
+    s32 sig = 0;
+    sigpending(&pending);
+    if (sigismember(&pending, SIGPIPE)) sigwait(&sigpipe, &sig);
   }
+  pthread_sigmask(SIG_SETMASK, &saved, SL_NULLPTR);
 
-  sb->network = opts->network;
+  if (err) {
+    snprintf(child->error, sizeof(child->error), "stdin: %s", strerror(err));
+    return -1;
+  }
+  return (s64)done;
+}
 
-  sb->platform.profile = build_profile(opts);
-  if (!sb->platform.profile) {
-    sb_destroy(sb);
-    return SL_NULLPTR;
+/* EOF for the child; stdin_fd is -1 afterwards. */
+sl_err_t sb_child_close_stdin(sl_child_t* child) {
+  if (!child) return SL_ERROR_INVALID_CONTEXT;
+  if (child->stdin_fd < 0) {
+    snprintf(child->error, sizeof(child->error), "stdin is not a pipe");
+    return SL_ERROR_INVALID_STDIO;
   }
 
-  return sb;
+  close(child->stdin_fd);
+  child->stdin_fd = -1;
+  return SL_OK;
 }
 
-sl_err_t sb_spawn(sl_ctx_t* sb, const c8* cmd, const c8* const* args, u32 num_args, sl_env_t env) {
-  if (!sb) return SL_ERROR_INVALID_CONTEXT;
-  if (!cmd) return SL_ERROR_INVALID_COMMAND;
-  if (num_args && !args) return SL_ERROR_INVALID_COMMAND;
-  if (sb->pid != -1) {
-    snprintf(sb->error, sizeof(sb->error), "already spawned");
-    return SL_ERROR;
-  }
+/* --- loop --------------------------------------------------------------- */
 
-  sp_try(sl_validate_ctx_scopes(sb));
+s32 sl_loop_child_fd(const sl_child_t* child, sl_loop_watch_t watch) {
+  if (watch == SL_LOOP_WATCH_STDOUT) return child->stdout_fd;
+  if (watch == SL_LOOP_WATCH_STDERR) return child->stderr_fd;
+  return child->pidfd;
+}
 
-  /* pipes: parent -> child stdin, child stdout -> parent, child stderr ->
-   * parent */
-  sl_pipes_t pipes = SL_NULL_PIPES;
-  if (pipe(pipes.in) || pipe(pipes.out) || pipe(pipes.err)) {
-    snprintf(sb->error, sizeof(sb->error), "pipe: %s", strerror(errno));
-    sl_pipes_try_close(&pipes);
-    return SL_ERROR_PIPE;
+static u64 sl_loop_token(u32 slot, u32 gen, sl_loop_watch_t watch) {
+  return ((u64)slot << 32) | ((u64)(gen & SL_LOOP_GEN_MASK) << 2) | (u64)watch;
+}
+
+/* `opts` may be NULL for the defaults. */
+sl_loop_t* sb_loop_create(const sb_loop_opts_t* opts) {
+  sl_loop_t* loop = sl_alloc_t(sl_loop_t);
+  if (!loop) return SL_NULLPTR;
+
+  loop->fd = -1;
+  loop->buffer = (u8*)sl_alloc(SL_LOOP_BUFFER);
+  if (!loop->buffer || !sl_platform_loop_open(loop, opts ? opts->backend : SL_LOOP_BACKEND_AUTO)) {
+    sl_free(loop->buffer);
+    sl_free(loop);
+    return SL_NULLPTR;
   }
+  return loop;
+}
 
-  const c8** argv = sl_alloc_n(const c8*, num_args + 2);
-  if (!argv) {
-    snprintf(sb->error, sizeof(sb->error), "alloc argv failed");
-    sl_pipes_try_close(&pipes);
-    return SL_ERROR;
+/* Children still registered are detached, not released. */
+void sb_loop_destroy(sl_loop_t* loop) {
+  if (!loop) return;
+
+  sl_for(it, loop->num_entries) {
+    if (loop->entries[it].live) loop->entries[it].child->loop = SL_NULLPTR;
   }
+  sl_platform_loop_close(loop);
+  sl_free(loop->entries);
+  sl_free(loop->buffer);
+  sl_free(loop);
+}
 
-  argv[0] = cmd;
-  sl_for(it, num_args) { argv[it + 1] = args[it]; }
-  argv[num_args + 1] = SL_NULLPTR;
+/* Readable whenever sb_loop_poll() has something; for embedding in another loop. */
+int sb_loop_fd(const sl_loop_t* loop) { return loop ? loop->fd : -1; }
 
-  pid_t pid = fork();
-  if (pid < 0) {
-    snprintf(sb->error, sizeof(sb->error), "fork: %s", strerror(errno));
-    sl_pipes_try_close(&pipes);
-    sl_free((void*)argv);
-    return SL_ERROR_FORK;
+sl_loop_backend_t sb_loop_backend(const sl_loop_t* loop) {
+  if (!loop) return SL_LOOP_BACKEND_AUTO;
+  return loop->uring ? SL_LOOP_BACKEND_IO_URING : SL_LOOP_BACKEND_POLL;
+}
+
+const c8* sb_loop_error(const sl_loop_t* loop) {
+  if (!loop) return "null loop";
+  return loop->error[0] ? loop->error : SL_NULLPTR;
+}
+
+static sl_loop_entry_t* sl_loop_claim(sl_loop_t* loop, u32* slot) {
+  sl_for(it, loop->num_entries) {
+    if (loop->entries[it].live) continue;
+    *slot = it;
+    return &loop->entries[it];
   }
 
-  if (pid == 0) {
-    /* --- child --- */
+  u32 capacity = loop->num_entries ? loop->num_entries * 2 : 16;
+  sl_loop_entry_t* entries = (sl_loop_entry_t*)sl_allocator_realloc(sl_rt.gpa, loop->entries, sizeof(sl_loop_entry_t) * capacity);
+  if (!entries) return SL_NULLPTR;
+  memset(entries + loop->num_entries, 0, sizeof(sl_loop_entry_t) * (capacity - loop->num_entries));
 
-    /* wire up stdio */
-    dup2(pipes.in[0], STDIN_FILENO);
-    dup2(pipes.out[1], STDOUT_FILENO);
-    dup2(pipes.err[1], STDERR_FILENO);
-    sl_pipes_try_close(&pipes);
+  loop->entries = entries;
+  *slot = loop->num_entries;
+  loop->num_entries = capacity;
+  return &loop->entries[*slot];
+}
 
-    /* apply sandbox */
-    char* sberr = NULL;
-    if (sb_init_fn(sb->platform.profile, 0, NULL, &sberr) != 0) {
-      fprintf(stderr, "sandbox_init: %s\n", sberr ? sberr : "unknown");
-      if (sberr) sb_free_fn(sberr);
-      _exit(126);
-    }
+/* Forgets the slot once nothing is left to report for it. */
+static bool sl_loop_settle(sl_loop_entry_t* entry) {
+  if (entry->watched[SL_LOOP_WATCH_STDOUT] || entry->watched[SL_LOOP_WATCH_STDERR]) return false;
+  if (entry->watched[SL_LOOP_WATCH_EXIT] || entry->poll_exit) return false;
 
-    /* exec */
-    if (env) {
-      execve(cmd, (char* const*)argv, (char* const*)env);
-    }
+  entry->child->loop = SL_NULLPTR;
+  entry->live = false;
+  entry->child = SL_NULLPTR;
+  return true;
+}
 
-    if (!env) {
-      extern char** environ;
-      execve(cmd, (char* const*)argv, environ);
-    }
+static void sl_loop_unwatch(sl_loop_t* loop, sl_loop_entry_t* entry, sl_loop_watch_t watch) {
+  if (!entry->watched[watch]) return;
+  sl_platform_loop_unwatch(loop, watch, entry->child, sl_loop_token((u32)(entry - loop->entries), entry->gen, watch));
+  entry->watched[watch] = false;
+}
+
+/*
+ * Watches the child's output pipes (whichever the parent owns) and its
+ * exit. Exits the kernel can't signal (no pidfd) are checked on every poll
+ * instead, with the wait capped at SL_LOOP_EXIT_POLL_MS.
+ */
+sl_err_t sb_loop_add_child(sl_loop_t* loop, sl_child_t* child, void* user) {
+  if (!loop || !child) return SL_ERROR_INVALID_CONTEXT;
+  if (child->pid < 0 || child->loop) {
+    snprintf(loop->error, sizeof(loop->error), "%s", child->loop ? "child is already in a loop" : "child not spawned");
+    return SL_ERROR;
+  }
 
-    /* exec failed */
-    fprintf(stderr, "execve(%s): %s\n", cmd, strerror(errno));
-    _exit(127);
+  u32 slot = 0;
+  sl_loop_entry_t* entry = sl_loop_claim(loop, &slot);
+  if (!entry) {
+    snprintf(loop->error, sizeof(loop->error), "failed to grow loop");
+    return SL_ERROR;
   }
 
-  /* --- parent --- */
-  close(pipes.in[0]);
-  close(pipes.out[1]);
-  close(pipes.err[1]);
+  u32 gen = entry->gen + 1;
+  *entry = (sl_loop_entry_t){ .child = child, .user = user, .gen = gen, .live = true };
+  child->loop = loop;
+  child->loop_slot = slot;
+
+  sl_loop_watch_t streams[] = { SL_LOOP_WATCH_STDOUT, SL_LOOP_WATCH_STDERR };
+  sl_for(it, 2) {
+    sl_loop_watch_t watch = streams[it];
+    if (sl_loop_child_fd(child, watch) < 0) continue;
+    if (!sl_platform_loop_watch(loop, watch, child, sl_loop_token(slot, gen, watch))) {
+      snprintf(loop->error, sizeof(loop->error), "watch: %s", strerror(errno));
+      sb_loop_remove_child(loop, child);
+      return SL_ERROR;
+    }
+    entry->watched[watch] = true;
+  }
 
-  sb->pid = pid;
-  sb->stdin_fd = pipes.in[1];
-  sb->stdout_fd = pipes.out[0];
-  sb->stderr_fd = pipes.err[0];
-  sb->exited = 0;
+  entry->watched[SL_LOOP_WATCH_EXIT] =
+    !child->exited && sl_platform_loop_watch(loop, SL_LOOP_WATCH_EXIT, child, sl_loop_token(slot, gen, SL_LOOP_WATCH_EXIT));
+  entry->poll_exit = !entry->watched[SL_LOOP_WATCH_EXIT];
+  if (entry->poll_exit) loop->num_poll_exit++;
 
-  sl_free((void*)argv);
+  if (!sl_platform_loop_commit(loop)) {
+    snprintf(loop->error, sizeof(loop->error), "watch: %s", strerror(errno));
+    sb_loop_remove_child(loop, child);
+    return SL_ERROR;
+  }
   return SL_OK;
 }
 
-pid_t sb_pid(const sl_ctx_t* sb) { return sb ? sb->pid : -1; }
-int sb_stdin_fd(const sl_ctx_t* sb) { return sb ? sb->stdin_fd : -1; }
-int sb_stdout_fd(const sl_ctx_t* sb) { return sb ? sb->stdout_fd : -1; }
-int sb_stderr_fd(const sl_ctx_t* sb) { return sb ? sb->stderr_fd : -1; }
+sl_err_t sb_loop_add(sl_loop_t* loop, sl_ctx_t* sb, void* user) {
+  if (!sb) return SL_ERROR_INVALID_CONTEXT;
+  return sb_loop_add_child(loop, &sb->child, user);
+}
 
-int sb_wait(sl_ctx_t* sb) {
-  if (!sb || sb->pid < 0) return -1;
-  if (sb->exited) return sb->exit_code;
+void sb_loop_remove_child(sl_loop_t* loop, sl_child_t* child) {
+  if (!loop || !child || child->loop != loop) return;
 
-  int status;
-  if (waitpid(sb->pid, &status, 0) < 0) {
-    snprintf(sb->error, sizeof(sb->error), "waitpid: %s", strerror(errno));
-    return -1;
-  }
+  sl_loop_entry_t* entry = &loop->entries[child->loop_slot];
+  sl_for(it, 3) { sl_loop_unwatch(loop, entry, (sl_loop_watch_t)it); }
+  if (entry->poll_exit) loop->num_poll_exit--;
+  entry->poll_exit = false;
+  sl_loop_settle(entry);
+  sl_platform_loop_commit(loop);
+}
 
-  sb->exited = 1;
-  sb->exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
-  return sb->exit_code;
+void sb_loop_remove(sl_loop_t* loop, sl_ctx_t* sb) {
+  if (sb) sb_loop_remove_child(loop, &sb->child);
 }
 
-int sb_kill(sl_ctx_t* sb, int sig) {
-  if (!sb || sb->pid < 0 || sb->exited) return -1;
-  if (kill(sb->pid, sig) < 0) {
-    snprintf(sb->error, sizeof(sb->error), "kill: %s", strerror(errno));
+static bool sl_loop_exit(sl_loop_t* loop, sl_loop_entry_t* entry, sl_loop_event_t* event) {
+  s32 code = sb_child_try_wait(entry->child);
+  if (code == SL_CHILD_RUNNING) return false;
+
+  *event = (sl_loop_event_t){
+    .kind = SL_LOOP_EXIT,
+    .child = entry->child,
+    .user = entry->user,
+    .exit_code = code,
+  };
+  sl_loop_unwatch(loop, entry, SL_LOOP_WATCH_EXIT);
+  if (entry->poll_exit) loop->num_poll_exit--;
+  entry->poll_exit = false;
+  return true;
+}
+
+/*
+ * One wait and the events it yields. It can come back empty before
+ * `timeout_ms`: a wake that turned out to be nothing (an io_uring read
+ * re-armed after running out of buffers, a stale readiness), the cap at
+ * SL_LOOP_EXIT_POLL_MS, or a signal.
+ */
+static int sl_loop_poll_once(sl_loop_t* loop, sl_loop_event_t* events, u32 max, s32 timeout_ms) {
+
+  u32 count = 0;
+  for (u32 it = 0; it < loop->num_entries && loop->num_poll_exit && count < max; it++) {
+    sl_loop_entry_t* entry = &loop->entries[it];
+    if (!entry->live || !entry->poll_exit) continue;
+    if (!sl_loop_exit(loop, entry, &events[count])) continue;
+    events[count++].last = sl_loop_settle(entry);
+  }
+
+  if (count == max) return (int)count;
+  if (count) timeout_ms = 0;
+  if (loop->num_poll_exit && (timeout_ms < 0 || timeout_ms > SL_LOOP_EXIT_POLL_MS)) timeout_ms = SL_LOOP_EXIT_POLL_MS;
+
+  sl_loop_ready_t ready[SL_LOOP_MAX_READY];
+  s32 n = sl_platform_loop_wait(loop, ready, max - count, timeout_ms);
+  if (n < 0 && errno == EINTR) return (int)count;
+  if (n < 0) {
+    snprintf(loop->error, sizeof(loop->error), "wait: %s", strerror(errno));
     return -1;
   }
-  return 0;
-}
 
-void sb_destroy(sl_ctx_t* sb) {
-  if (!sb || sb->destroyed) return;
-  sb->destroyed = 1;
+  u64 used = 0;
+  sl_for(it, (u32)n) {
+    u32 slot = (u32)(ready[it].token >> 32);
+    u32 gen = (u32)(ready[it].token >> 2) & SL_LOOP_GEN_MASK;
+    sl_loop_watch_t watch = (sl_loop_watch_t)(ready[it].token & 3);
+    if (slot >= loop->num_entries) continue;
+
+    sl_loop_entry_t* entry = &loop->entries[slot];
+    if (!entry->live || (entry->gen & SL_LOOP_GEN_MASK) != gen || !entry->watched[watch]) continue;
+
+    if (watch == SL_LOOP_WATCH_EXIT) {
+      if (!sl_loop_exit(loop, entry, &events[count])) {
+        /* A one-shot poll fired early; keep checking on every poll instead */
+        if (ready[it].done) {
+          entry->watched[SL_LOOP_WATCH_EXIT] = false;
+          entry->poll_exit = true;
+          loop->num_poll_exit++;
+        }
+        continue;
+      }
+      events[count++].last = sl_loop_settle(entry);
+      continue;
+    }
 
-  if (sb->pid > 0 && !sb->exited) {
-    kill(sb->pid, SIGKILL);
-    int status;
-    waitpid(sb->pid, &status, 0);
+    const u8* data = ready[it].data;
+    s64 got = ready[it].res;
+    if (!ready[it].done) {
+      if (used == SL_LOOP_BUFFER) continue;
+      u64 room = SL_LOOP_BUFFER - used < SL_LOOP_READ ? SL_LOOP_BUFFER - used : SL_LOOP_READ;
+      data = loop->buffer + used;
+      got = read(sl_loop_child_fd(entry->child, watch), loop->buffer + used, room);
+      if (got < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+    }
+
+    /* A read error ends the stream just like EOF */
+    u64 len = got > 0 ? (u64)got : 0;
+    sl_loop_event_t* event = &events[count++];
+    *event = (sl_loop_event_t){
+      .kind = watch == SL_LOOP_WATCH_STDOUT ? SL_LOOP_STDOUT : SL_LOOP_STDERR,
+      .child = entry->child,
+      .user = entry->user,
+      .data = len ? data : SL_NULLPTR,
+      .len = len,
+    };
+    if (!ready[it].done) used += len;
+
+    if (!len) {
+      sl_loop_unwatch(loop, entry, watch);
+      event->last = sl_loop_settle(entry);
+    }
   }
 
-  if (sb->stdin_fd >= 0) close(sb->stdin_fd);
-  if (sb->stdout_fd >= 0) close(sb->stdout_fd);
-  if (sb->stderr_fd >= 0) close(sb->stderr_fd);
-  for (u32 i = 0; i < sb->write.num_dirs; i++)
-    sl_free((void*)sb->write.dirs[i]);
-  sl_free((void*)sb->write.dirs);
-  for (u32 i = 0; i < sb->read.num_dirs; i++)
-    sl_free((void*)sb->read.dirs[i]);
-  sl_free((void*)sb->read.dirs);
-  sl_free((void*)sb->platform.profile);
-  sl_free(sb);
+  return (int)count;
 }
 
-const c8* sb_error(const sl_ctx_t* sb) {
-  if (!sb) return "null sandbox";
-  return sb->error[0] ? sb->error : SL_NULLPTR;
+/*
+ * Waits up to `timeout_ms` (negative: forever) for anything to happen, then
+ * reports at most `max` events: one read of up to SL_LOOP_READ per ready
+ * pipe, until SL_LOOP_BUFFER is used up, and one event per exit. Readiness
+ * is level-triggered, so whatever doesn't fit is reported next time. On
+ * io_uring each event is one completed read of up to SL_URING_BUF_SIZE,
+ * and completions past `max` wait in the ring. Empty wakes are waited
+ * through, so 0 means the timeout passed.
+ * Returns the number of events, or -1 (see sb_loop_error()).
+ */
+int sb_loop_poll(sl_loop_t* loop, sl_loop_event_t* events, u32 max, s32 timeout_ms) {
+  if (!loop || !events) return -1;
+  if (max > SL_LOOP_MAX_READY) max = SL_LOOP_MAX_READY;
+
+  u64 deadline = timeout_ms > 0 ? sl_now_ms() + (u64)timeout_ms : 0;
+  while (true) {
+    int count = sl_loop_poll_once(loop, events, max, timeout_ms);
+    if (count || !timeout_ms) return count;
+    if (timeout_ms < 0) continue;
+
+    u64 now = sl_now_ms();
+    if (now >= deadline) return 0;
+    timeout_ms = (s32)(deadline - now);
+  }
 }
 
-#endif
+void sb_child_destroy(sl_child_t* child) {
+  if (!child) return;
+  sl_child_release(child);
+  sl_free(child);
+}
+
+const c8* sb_child_error(const sl_child_t* child) {
+  if (!child) return "null child";
+  return child->error[0] ? child->error : SL_NULLPTR;
+}
 
 #endif
 
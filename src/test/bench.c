@@ -0,0 +1,297 @@
+#define SP_IMPLEMENTATION
+#define STEVELOCK_IMPLEMENTATION
+#define ARGPARSE_IMPLEMENTATION
+#include "sp.h"
+#include "argparse.h"
+#include "stevelock.h"
+
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/*
+ * Latency of every stage of a sandboxed spawn, as percentiles, across a
+ * matrix of scope sizes, network policy and parent RSS. Each iteration:
+ *
+ *   create  sb_create() with `dirs` write scopes
+ *   spawn   sb_spawn() returning
+ *   exec    sb_spawn() start to the first byte the testbox writes, i.e. the
+ *           child is running its own code under the sandbox
+ *   wait    sb_wait() once that byte has arrived
+ *   fork    plain fork()+execve() of the same binary, for comparison
+ *
+ * The RSS ballast has every page touched so it is really resident; fork
+ * grows with the page table it copies, sb_spawn should not. Pass --json for
+ * one JSON object per (config, phase) line, suitable for tracking across
+ * releases, and --zygote to spawn through a zygote started before the
+ * ballast is allocated.
+ */
+
+#define SL_BENCH_MAX_STEPS 16
+
+typedef enum {
+  SL_BENCH_CREATE,
+  SL_BENCH_SPAWN,
+  SL_BENCH_EXEC,
+  SL_BENCH_WAIT,
+  SL_BENCH_FORK,
+  SL_BENCH_NUM_PHASES,
+} sl_bench_phase_t;
+
+static const c8* sl_bench_phase_names[SL_BENCH_NUM_PHASES] = {
+  "create",
+  "spawn",
+  "exec",
+  "wait",
+  "fork",
+};
+
+typedef struct {
+  u64* samples;
+  u32 n;
+} sl_bench_stat_t;
+
+typedef struct {
+  u32 dirs;
+  bool network;
+  u32 rss_mb;
+} sl_bench_config_t;
+
+typedef struct {
+  u32 values[SL_BENCH_MAX_STEPS];
+  u32 count;
+} sl_bench_steps_t;
+
+static s32 sl_bench_cmp_u64(const void* a, const void* b) {
+  u64 x = *(const u64*)a;
+  u64 y = *(const u64*)b;
+  return (x > y) - (x < y);
+}
+
+static f64 sl_bench_percentile_us(sl_bench_stat_t* stat, f64 p) {
+  if (!stat->n) return 0.0;
+  u32 index = (u32)(p * (f64)(stat->n - 1) + 0.5);
+  return (f64)stat->samples[index] / 1000.0;
+}
+
+static sl_bench_steps_t sl_bench_parse_steps(const c8* list) {
+  sl_bench_steps_t steps = SL_ZERO;
+  const c8* it = list;
+  while (it && *it && steps.count < SL_BENCH_MAX_STEPS) {
+    c8* end = SL_NULLPTR;
+    steps.values[steps.count++] = (u32)strtoul(it, &end, 10);
+    if (end == it) break;
+    it = *end == ',' ? end + 1 : end;
+  }
+  return steps;
+}
+
+static sp_str_t sl_bench_testbox_path() {
+  sp_str_t dir = sp_fs_get_exe_path();
+  return sp_str_null_terminate(sp_fs_join_path(dir, SP_LIT("stevelock_testbox")));
+}
+
+/* Makes `count` sibling directories under a fresh temp root. */
+static c8** sl_bench_make_dirs(c8* root, u32 count) {
+  c8** dirs = sl_alloc_n(c8*, count ? count : 1);
+  if (!dirs) return SL_NULLPTR;
+
+  sl_for(it, count) {
+    dirs[it] = sl_alloc_n(c8, PATH_MAX);
+    snprintf(dirs[it], PATH_MAX, "%s/%u", root, it);
+    mkdir(dirs[it], 0700);
+  }
+  return dirs;
+}
+
+static void sl_bench_free_dirs(c8** dirs, u32 count) {
+  sl_for(it, count) {
+    rmdir(dirs[it]);
+    sl_free(dirs[it]);
+  }
+  sl_free(dirs);
+}
+
+static bool sl_bench_sandboxed(const c8* cmd, c8** dirs, const sl_bench_config_t* config, u64* out) {
+  const c8* args[] = { "emit", "--stdout", "x" };
+
+  sb_opts_t opts = {
+    .write = { .dirs = dirs, .num_dirs = config->dirs },
+    .network = config->network,
+  };
+
+  sp_tm_point_t start = sp_tm_now_point();
+  sl_ctx_t* sb = sb_create(&opts);
+  out[SL_BENCH_CREATE] = sp_tm_point_diff(sp_tm_now_point(), start);
+  if (!sb) return false;
+
+  start = sp_tm_now_point();
+  sl_err_t err = sb_spawn(sb, cmd, args, SP_CARR_LEN(args), SL_NULLPTR);
+  out[SL_BENCH_SPAWN] = sp_tm_point_diff(sp_tm_now_point(), start);
+  if (err) {
+    sb_destroy(sb);
+    return false;
+  }
+
+  c8 byte = 0;
+  bool ok = read(sb_stdout_fd(sb), &byte, 1) == 1;
+  out[SL_BENCH_EXEC] = sp_tm_point_diff(sp_tm_now_point(), start);
+
+  start = sp_tm_now_point();
+  ok = sb_wait(sb) == 0 && ok;
+  out[SL_BENCH_WAIT] = sp_tm_point_diff(sp_tm_now_point(), start);
+
+  sb_destroy(sb);
+  return ok;
+}
+
+static bool sl_bench_fork(const c8* cmd, u64* out) {
+  extern char** environ;
+  const c8* argv[] = { cmd, "status", "--code", "0", SL_NULLPTR };
+
+  sp_tm_point_t start = sp_tm_now_point();
+  pid_t pid = fork();
+  if (pid == 0) {
+    execve(cmd, (char* const*)argv, environ);
+    _exit(127);
+  }
+  out[SL_BENCH_FORK] = sp_tm_point_diff(sp_tm_now_point(), start);
+
+  if (pid < 0) return false;
+  s32 status = 0;
+  waitpid(pid, &status, 0);
+  return true;
+}
+
+static void sl_bench_report(sl_bench_config_t* config, sl_bench_stat_t* stats, bool json) {
+  sl_for(phase, SL_BENCH_NUM_PHASES) {
+    sl_bench_stat_t* stat = &stats[phase];
+    qsort(stat->samples, stat->n, sizeof(u64), sl_bench_cmp_u64);
+
+    f64 p50 = sl_bench_percentile_us(stat, 0.50);
+    f64 p99 = sl_bench_percentile_us(stat, 0.99);
+    f64 p999 = sl_bench_percentile_us(stat, 0.999);
+    f64 max = sl_bench_percentile_us(stat, 1.0);
+
+    if (json) {
+      printf("{\"phase\":\"%s\",\"dirs\":%u,\"network\":%s,\"rss_mb\":%u,\"n\":%u,"
+             "\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f}\n",
+        sl_bench_phase_names[phase], config->dirs, config->network ? "true" : "false", config->rss_mb, stat->n,
+        p50, p99, p999, max);
+      continue;
+    }
+
+    printf("%8u %8s %8u %8s %10.1f %10.1f %10.1f %10.1f\n",
+      config->dirs, config->network ? "on" : "off", config->rss_mb, sl_bench_phase_names[phase], p50, p99, p999, max);
+  }
+  fflush(stdout);
+}
+
+int main(int argc, const char** argv) {
+  s32 iterations = 200;
+  const c8* dirs_list = "0,10,100,500";
+  const c8* rss_list = "0,256,1024";
+  s32 json = 0;
+  s32 zygote = 0;
+
+  struct argparse_option options[] = {
+    OPT_HELP(),
+    OPT_INTEGER('n', "iterations", &iterations, "spawns per configuration", NULL, 0, 0),
+    OPT_STRING(0, "dirs", &dirs_list, "comma-separated write scope sizes", NULL, 0, 0),
+    OPT_STRING(0, "rss-mb", &rss_list, "comma-separated parent ballast sizes, in MiB", NULL, 0, 0),
+    OPT_BOOLEAN(0, "json", &json, "one JSON object per line", NULL, 0, 0),
+    OPT_BOOLEAN(0, "zygote", &zygote, "spawn through a zygote", NULL, 0, 0),
+    OPT_END(),
+  };
+
+  struct argparse argparse;
+  argparse_init(&argparse, options, NULL, 0);
+  argparse_parse(&argparse, argc, argv);
+
+  sb_runtime_opts_t runtime = { .zygote = zygote != 0 };
+  sl_err_t init = sb_runtime_init(&runtime);
+  if (init) {
+    fprintf(stderr, "sb_runtime_init: %s\n", sl_err_to_string(init));
+    return 1;
+  }
+
+  sp_str_t cmd = sl_bench_testbox_path();
+  sl_bench_steps_t dir_steps = sl_bench_parse_steps(dirs_list);
+  sl_bench_steps_t rss_steps = sl_bench_parse_steps(rss_list);
+
+  u32 max_dirs = 0;
+  sl_for(it, dir_steps.count) {
+    if (dir_steps.values[it] > max_dirs) max_dirs = dir_steps.values[it];
+  }
+
+  c8 root[] = "/tmp/stevelock-bench-XXXXXX";
+  if (!mkdtemp(root)) {
+    fprintf(stderr, "mkdtemp: %s\n", strerror(errno));
+    return 1;
+  }
+  c8** dirs = sl_bench_make_dirs(root, max_dirs);
+
+  sl_bench_stat_t stats[SL_BENCH_NUM_PHASES] = SL_ZERO;
+  sl_for(phase, SL_BENCH_NUM_PHASES) {
+    stats[phase].samples = sl_alloc_n(u64, iterations > 0 ? iterations : 1);
+  }
+
+  if (!json) {
+    printf("%8s %8s %8s %8s %10s %10s %10s %10s\n", "dirs", "network", "rss_mb", "phase", "p50_us", "p99_us", "p999_us", "max_us");
+  }
+
+  s32 failures = 0;
+  u8* ballast = SL_NULLPTR;
+  sl_for(rss_it, rss_steps.count) {
+    u64 size = (u64)rss_steps.values[rss_it] * 1024 * 1024;
+    sl_free(ballast);
+    ballast = size ? (u8*)sl_alloc(size) : SL_NULLPTR;
+    if (size && !ballast) {
+      fprintf(stderr, "failed to allocate %u MiB ballast\n", rss_steps.values[rss_it]);
+      break;
+    }
+    for (u64 it = 0; it < size; it += 4096) {
+      ballast[it] = (u8)it;
+    }
+
+    sl_for(dir_it, dir_steps.count) {
+      sl_for(network, 2) {
+        sl_bench_config_t config = {
+          .dirs = dir_steps.values[dir_it],
+          .network = network == 1,
+          .rss_mb = rss_steps.values[rss_it],
+        };
+
+        sl_for(phase, SL_BENCH_NUM_PHASES) { stats[phase].n = 0; }
+
+        sl_for(it, (u32)iterations) {
+          u64 sample[SL_BENCH_NUM_PHASES] = SL_ZERO;
+          bool ok = sl_bench_sandboxed(cmd.data, dirs, &config, sample);
+          ok = sl_bench_fork(cmd.data, sample) && ok;
+          if (!ok) {
+            failures++;
+            continue;
+          }
+
+          sl_for(phase, SL_BENCH_NUM_PHASES) {
+            stats[phase].samples[stats[phase].n++] = sample[phase];
+          }
+        }
+
+        sl_bench_report(&config, stats, json);
+      }
+    }
+  }
+
+  sl_for(phase, SL_BENCH_NUM_PHASES) { sl_free(stats[phase].samples); }
+  sl_free(ballast);
+  sl_bench_free_dirs(dirs, max_dirs);
+  rmdir(root);
+  sb_runtime_shutdown();
+
+  if (failures) {
+    fprintf(stderr, "%d iterations failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -302,10 +302,14 @@ static int testbox_sleep(int argc, const char** argv) {
 static int testbox_emit(int argc, const char** argv) {
   const char* out = NULL;
   const char* err = NULL;
+  int repeat = 1;
+  int forever = 0;
 
   struct argparse_option options[] = {
     OPT_STRING(0, "stdout", &out, "stdout text", NULL, 0, 0),
     OPT_STRING(0, "stderr", &err, "stderr text", NULL, 0, 0),
+    OPT_INTEGER(0, "repeat", &repeat, "times to write the text", NULL, 0, 0),
+    OPT_BOOLEAN(0, "forever", &forever, "write until killed", NULL, 0, 0),
     OPT_END(),
   };
 
@@ -313,11 +317,63 @@ static int testbox_emit(int argc, const char** argv) {
   argparse_init(&argparse, options, NULL, 0);
   argparse_parse(&argparse, argc, argv);
 
-  if (out) {
-    fwrite(out, 1, strlen(out), stdout);
+  for (int i = 0; forever || i < repeat; i++) {
+    if (out) {
+      fwrite(out, 1, strlen(out), stdout);
+    }
+    if (err) {
+      fwrite(err, 1, strlen(err), stderr);
+    }
   }
-  if (err) {
-    fwrite(err, 1, strlen(err), stderr);
+  return 0;
+}
+
+/* Writes `size` bytes, then leaves a grandchild to truncate stdout after `ms`. */
+static int testbox_truncate_later(int argc, const char** argv) {
+  int size = 0;
+  int ms = 0;
+
+  struct argparse_option options[] = {
+    OPT_INTEGER(0, "size", &size, "bytes to write first", NULL, 0, 0),
+    OPT_INTEGER(0, "ms", &ms, "milliseconds before truncating", NULL, 0, 0),
+    OPT_END(),
+  };
+
+  struct argparse argparse;
+  argparse_init(&argparse, options, NULL, 0);
+  argparse_parse(&argparse, argc, argv);
+
+  char buffer[4096];
+  memset(buffer, 'x', sizeof(buffer));
+  for (int done = 0; done < size;) {
+    int chunk = size - done < (int)sizeof(buffer) ? size - done : (int)sizeof(buffer);
+    ssize_t n = write(STDOUT_FILENO, buffer, (size_t)chunk);
+    if (n <= 0) {
+      return 2;
+    }
+    done += (int)n;
+  }
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    return 3;
+  }
+  if (pid == 0) {
+    usleep((useconds_t)(ms * 1000));
+    _exit(ftruncate(STDOUT_FILENO, 0) == 0 ? 0 : 1);
+  }
+  return 0;
+}
+
+/* The descriptors above stderr this process started with, space-separated. */
+static int testbox_fds(void) {
+  const char* sep = "";
+  for (int fd = 3; fd < 1024; fd++) {
+    if (fcntl(fd, F_GETFD) < 0) {
+      continue;
+    }
+    printf("%s%d", sep, fd);
+    sep = " ";
   }
   return 0;
 }
@@ -365,6 +421,12 @@ int main(int argc, const char** argv) {
   if (strcmp(cmd, "emit") == 0) {
     return testbox_emit(argc - 1, argv + 1);
   }
+  if (strcmp(cmd, "fds") == 0) {
+    return testbox_fds();
+  }
+  if (strcmp(cmd, "truncate-later") == 0) {
+    return testbox_truncate_later(argc - 1, argv + 1);
+  }
 
   return 1;
 }
@@ -10,6 +10,7 @@
 #include "stevelock.h"
 
 #include <signal.h>
+#include <sys/socket.h>
 
 #define ut (*utest_fixture)
 #define ur (*utest_result)
@@ -239,27 +240,13 @@ static sl_test_exec_result_t sl_test_run_exec(sl_test_exec_t spec) {
     return result;
   }
 
+  /* A child that exits without reading is an error here, not a SIGPIPE */
   if (!sp_str_empty(spec.process.stdin_data)) {
-    s32 fd = sb_stdin_fd(sb);
-    const c8* data = spec.process.stdin_data.data;
-    u32 remaining = spec.process.stdin_data.len;
-
-    while (remaining > 0) {
-      s64 n = sp_write(fd, data, remaining);
-      if (n <= 0) {
-        break;
-      }
-      data += n;
-      remaining -= (u32)n;
-    }
-
-    if (spec.process.close_stdin) {
-      sp_close(fd);
-    }
+    sb_write_stdin(sb, spec.process.stdin_data.data, spec.process.stdin_data.len, 0);
   }
 
-  if (sp_str_empty(spec.process.stdin_data) && spec.process.close_stdin) {
-    sp_close(sb_stdin_fd(sb));
+  if (spec.process.close_stdin) {
+    sb_close_stdin(sb);
   }
 
   if (spec.kill_after_spawn) {
@@ -121,6 +121,981 @@ UTEST_F(stevelock, api_validation) {
   }
 }
 
+UTEST_F(stevelock, spawn_missing_command) {
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+
+  /* reported by sb_spawn itself, not as exit code 127 after the fact */
+  sl_err_t err = sb_spawn(sb, "/nonexistent/stevelock-command", SL_NULLPTR, 0, SL_NULLPTR);
+  ASSERT_EQ(err, SL_ERROR_EXEC);
+  ASSERT_TRUE(sb_error(sb) != SL_NULLPTR);
+  EXPECT_TRUE(strstr(sb_error(sb), "/nonexistent/stevelock-command") != SL_NULLPTR);
+  EXPECT_TRUE(strstr(sb_error(sb), strerror(ENOENT)) != SL_NULLPTR);
+  EXPECT_LT(sb_pid(sb), 0);
+
+  /* nothing was left running, so the context can spawn again */
+  sp_str_t cmd = sp_str_null_terminate(sl_test_testbox_path());
+  const c8* args[] = { "status", "--code", "0" };
+  ASSERT_EQ(sb_spawn(sb, cmd.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+  EXPECT_EQ(sb_wait(sb), 0);
+
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, multi_child) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+
+  const c8* outputs[] = {
+    "child-0",
+    "child-1",
+    "child-2",
+    "child-3",
+  };
+
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+
+  sl_child_t* children[SP_CARR_LEN(outputs)] = SL_ZERO;
+  sl_for(it, SP_CARR_LEN(outputs)) {
+    const c8* args[] = {
+      "emit",
+      "--stdout",
+      outputs[it],
+    };
+    EXPECT_EQ(sb_spawn_child(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR, &children[it]), SL_OK);
+    ASSERT_TRUE(children[it] != SL_NULLPTR);
+    EXPECT_GT(sb_child_pid(children[it]), 0);
+  }
+
+  /* children are independent of the context that launched them */
+  EXPECT_LT(sb_pid(sb), 0);
+  sb_destroy(sb);
+
+  sl_for(it, SP_CARR_LEN(outputs)) {
+    EXPECT_EQ(sb_child_wait(children[it]), 0);
+    EXPECT_EQ(sb_child_wait(children[it]), 0);
+
+    c8 buffer[64] = SL_ZERO;
+    sp_str_t out = sl_test_read_fd(sb_child_stdout_fd(children[it]), buffer, SP_CARR_LEN(buffer));
+    EXPECT_TRUE(sp_str_equal_cstr(out, outputs[it]));
+
+    EXPECT_EQ(sb_child_kill(children[it], SIGKILL), -1);
+    sb_child_destroy(children[it]);
+  }
+}
+
+UTEST_F(stevelock, multi_child_kill) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = {
+    "sleep",
+  };
+
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+
+  sl_child_t* a = SL_NULLPTR;
+  sl_child_t* b = SL_NULLPTR;
+  ASSERT_EQ(sb_spawn_child(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR, &a), SL_OK);
+  ASSERT_EQ(sb_spawn_child(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR, &b), SL_OK);
+  EXPECT_NE(sb_child_pid(a), sb_child_pid(b));
+
+  EXPECT_EQ(sb_child_kill(a, SIGKILL), 0);
+  EXPECT_EQ(sb_child_wait(a), 128 + SIGKILL);
+
+  /* destroying a live child kills and reaps it */
+  sb_child_destroy(b);
+  sb_child_destroy(a);
+
+  EXPECT_EQ(sb_spawn_child(sb, SL_NULLPTR, SL_NULLPTR, 0, SL_NULLPTR, &a), SL_ERROR_INVALID_COMMAND);
+  EXPECT_EQ(sb_spawn_child(SL_NULLPTR, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR, &a), SL_ERROR_INVALID_CONTEXT);
+  EXPECT_LT(sb_child_pid(SL_NULLPTR), 0);
+  EXPECT_EQ(sb_child_wait(SL_NULLPTR), -1);
+
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, spawn_many) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* codes[][3] = {
+    { "status", "--code", "3" },
+    { "status", "--code", "4" },
+    { "status", "--code", "5" },
+  };
+
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+
+  sb_spawn_spec_t specs[SP_CARR_LEN(codes)] = SL_ZERO;
+  sl_for(it, SP_CARR_LEN(codes)) {
+    specs[it] = (sb_spawn_spec_t) { .cmd = cmd_cstr.data, .args = codes[it], .num_args = 3 };
+  }
+
+  sl_child_t* children[SP_CARR_LEN(codes)] = SL_ZERO;
+  ASSERT_EQ(sb_spawn_many(sb, specs, SP_CARR_LEN(specs), children), SL_OK);
+  sl_for(it, SP_CARR_LEN(children)) {
+    EXPECT_GT(sb_child_pid(children[it]), 0);
+    EXPECT_EQ(sb_child_wait(children[it]), 3 + (s32)it);
+    sb_child_destroy(children[it]);
+  }
+
+  /* one bad spec fails the whole batch before anything starts */
+  specs[1].cmd = SL_NULLPTR;
+  sl_child_t* untouched[SP_CARR_LEN(codes)] = SL_ZERO;
+  EXPECT_EQ(sb_spawn_many(sb, specs, SP_CARR_LEN(specs), untouched), SL_ERROR_INVALID_COMMAND);
+  sl_for(it, SP_CARR_LEN(untouched)) { EXPECT_TRUE(untouched[it] == SL_NULLPTR); }
+
+  EXPECT_EQ(sb_spawn_many(sb, specs, 0, SL_NULLPTR), SL_OK);
+  EXPECT_EQ(sb_spawn_many(SL_NULLPTR, specs, 1, children), SL_ERROR_INVALID_CONTEXT);
+
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, try_wait) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = {
+    "sleep",
+    "--ms",
+    "200",
+  };
+
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  EXPECT_EQ(sb_try_wait(sb), -1);
+  EXPECT_EQ(sb_pidfd(sb), -1);
+
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+  if (sl_capabilities()->pidfd) {
+    EXPECT_GE(sb_pidfd(sb), 0);
+  }
+
+  EXPECT_EQ(sb_try_wait(sb), SL_CHILD_RUNNING);
+  EXPECT_EQ(sb_wait_timeout(sb, 10), SL_CHILD_RUNNING);
+  EXPECT_EQ(sb_wait_timeout(sb, 5000), 0);
+  EXPECT_EQ(sb_try_wait(sb), 0);
+  EXPECT_EQ(sb_wait(sb), 0);
+
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, spawn_stats) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = {
+    "status",
+    "--code",
+    "0",
+  };
+
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+
+  const sl_stats_t* stats = sb_stats(sb);
+  ASSERT_TRUE(stats != SL_NULLPTR);
+  EXPECT_EQ(stats->num_spawns, 0u);
+  EXPECT_EQ(stats->spawn_ns, 0u);
+
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+  EXPECT_EQ(stats->num_spawns, 1u);
+  EXPECT_GT(stats->fork_ns, 0u);
+  EXPECT_GT(stats->restrict_ns, 0u);
+  EXPECT_GT(stats->exec_ns, 0u);
+  EXPECT_GE(stats->spawn_ns, stats->fork_ns + stats->setup_ns + stats->restrict_ns + stats->exec_ns);
+  EXPECT_EQ(sb_wait(sb), 0);
+
+  sl_child_t* child = SL_NULLPTR;
+  ASSERT_EQ(sb_spawn_child(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR, &child), SL_OK);
+  EXPECT_EQ(stats->num_spawns, 2u);
+  sb_child_destroy(child);
+
+  EXPECT_TRUE(sb_stats(SL_NULLPTR) == SL_NULLPTR);
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, stdio_modes) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = {
+    "emit",
+    "--stdout",
+    "out",
+    "--stderr",
+    "err",
+  };
+  c8 buffer[64];
+
+  /* stderr merged into the stdout pipe; no stdin or stderr pipe at all */
+  sb_opts_t opts = {
+    .stdio = {
+      .in = { .mode = SL_STDIO_NULL },
+      .err = { .mode = SL_STDIO_MERGE },
+    },
+  };
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+  EXPECT_EQ(sb_stdin_fd(sb), -1);
+  EXPECT_EQ(sb_stderr_fd(sb), -1);
+  sp_str_t merged = sl_test_read_fd(sb_stdout_fd(sb), buffer, sizeof(buffer));
+  /* stdout is block-buffered into a pipe, so order isn't guaranteed */
+  EXPECT_EQ(merged.len, 6u);
+  EXPECT_TRUE(strstr(buffer, "out") != SL_NULLPTR);
+  EXPECT_TRUE(strstr(buffer, "err") != SL_NULLPTR);
+  EXPECT_EQ(sb_wait(sb), 0);
+
+  /* a per-spawn override: stdout into a caller's fd, stderr discarded */
+  s32 file[2] = SL_NULL_PIPE;
+  ASSERT_EQ(pipe(file), 0);
+  sl_stdio_t stdio = {
+    .out = { .mode = SL_STDIO_FD, .fd = file[1] },
+    .err = { .mode = SL_STDIO_NULL },
+  };
+  sb_spawn_spec_t spec = {
+    .cmd = cmd_cstr.data,
+    .args = args,
+    .num_args = SP_CARR_LEN(args),
+    .stdio = &stdio,
+  };
+  sl_child_t* child = SL_NULLPTR;
+  ASSERT_EQ(sb_spawn_many(sb, &spec, 1, &child), SL_OK);
+  EXPECT_GE(sb_child_stdin_fd(child), 0);
+  EXPECT_EQ(sb_child_stdout_fd(child), -1);
+  EXPECT_EQ(sb_child_stderr_fd(child), -1);
+  EXPECT_EQ(sb_child_wait(child), 0);
+  sb_child_destroy(child);
+
+  /* the caller's fd is still open and still the caller's */
+  close(file[1]);
+  sp_str_t passed = sl_test_read_fd(file[0], buffer, sizeof(buffer));
+  EXPECT_TRUE(sp_str_equal(passed, SP_LIT("out")));
+  close(file[0]);
+
+  /* an inherited stream arrives even when ours is close-on-exec, as Node's stdio is */
+  fflush(stdout);
+  s32 saved = dup(STDOUT_FILENO);
+  ASSERT_EQ(pipe(file), 0);
+  ASSERT_EQ(dup2(file[1], STDOUT_FILENO), STDOUT_FILENO);
+  close(file[1]);
+  fcntl(STDOUT_FILENO, F_SETFD, FD_CLOEXEC);
+  stdio.out = (sl_stdio_stream_t){ .mode = SL_STDIO_INHERIT };
+  sl_err_t err = sb_spawn_many(sb, &spec, 1, &child);
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+  ASSERT_EQ(err, SL_OK);
+  EXPECT_EQ(sb_child_wait(child), 0);
+  sb_child_destroy(child);
+  sp_str_t inherited = sl_test_read_fd(file[0], buffer, sizeof(buffer));
+  EXPECT_TRUE(sp_str_equal(inherited, SP_LIT("out")));
+  close(file[0]);
+
+  stdio.out = (sl_stdio_stream_t){ .mode = SL_STDIO_MERGE };
+  EXPECT_EQ(sb_spawn_many(sb, &spec, 1, &child), SL_ERROR_INVALID_STDIO);
+  stdio.out = (sl_stdio_stream_t){ .mode = SL_STDIO_FD, .fd = -1 };
+  EXPECT_EQ(sb_spawn_many(sb, &spec, 1, &child), SL_ERROR_INVALID_STDIO);
+
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, forward) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = {
+    "emit",
+    "--stdout",
+    "out",
+    "--stderr",
+    "err",
+  };
+  c8 buffer[64];
+
+  c8 path[] = "/tmp/stevelock-forward-XXXXXX";
+  s32 file = mkstemp(path);
+  ASSERT_GE(file, 0);
+  unlink(path);
+  s32 sink[2] = SL_NULL_PIPE;
+  ASSERT_EQ(pipe(sink), 0);
+
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+
+  /* stdout spliced into a file with a copy kept, stderr into a pipe */
+  ASSERT_EQ(sb_forward(sb, SL_STDOUT, file, SL_FORWARD_TEE), SL_OK);
+  ASSERT_EQ(sb_forward(sb, SL_STDERR, sink[1], 0), SL_OK);
+  EXPECT_EQ(sb_stdout_fd(sb), -1);
+  EXPECT_EQ(sb_stderr_fd(sb), -1);
+  EXPECT_EQ(sb_forward(sb, SL_STDOUT, file, 0), SL_ERROR_INVALID_STDIO);
+  close(sink[1]);
+
+  sl_forward_result_t out = SL_ZERO;
+  EXPECT_EQ(sb_forward_wait(sb, SL_STDOUT, &out), SL_OK);
+  EXPECT_EQ(out.bytes, 3u);
+  EXPECT_EQ(out.copy_len, 3u);
+  EXPECT_EQ(memcmp(out.copy, "out", 3), 0);
+  sl_free(out.copy);
+
+  sl_forward_result_t err = SL_ZERO;
+  EXPECT_EQ(sb_forward_wait(sb, SL_STDERR, &err), SL_OK);
+  EXPECT_EQ(err.bytes, 3u);
+  EXPECT_TRUE(err.copy == SL_NULLPTR);
+  EXPECT_EQ(sb_forward_wait(sb, SL_STDERR, &err), SL_ERROR_INVALID_STDIO);
+  EXPECT_EQ(sb_wait(sb), 0);
+
+  /* the destinations stayed the caller's */
+  sp_str_t piped = sl_test_read_fd(sink[0], buffer, sizeof(buffer));
+  EXPECT_TRUE(sp_str_equal(piped, SP_LIT("err")));
+  ASSERT_EQ(lseek(file, 0, SEEK_SET), 0);
+  sp_str_t written = sl_test_read_fd(file, buffer, sizeof(buffer));
+  EXPECT_TRUE(sp_str_equal(written, SP_LIT("out")));
+
+  /* a full non-blocking destination is waited on, spliced or copied, kept or not */
+  const c8* flood_args[] = { "emit", "--stdout", "0123456789", "--stderr", "0123456789", "--repeat", "100000" };
+  s32 socks[2][2];
+  sl_for(it, 2) {
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, socks[it]), 0);
+    fcntl(socks[it][1], F_SETFL, fcntl(socks[it][1], F_GETFL) | O_NONBLOCK);
+  }
+  sl_ctx_t* flood = sb_create(&opts);
+  ASSERT_TRUE(flood != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(flood, cmd_cstr.data, flood_args, SP_CARR_LEN(flood_args), SL_NULLPTR), SL_OK);
+  ASSERT_EQ(sb_forward(flood, SL_STDOUT, socks[0][1], SL_FORWARD_TEE), SL_OK);
+  ASSERT_EQ(sb_forward(flood, SL_STDERR, socks[1][1], 0), SL_OK);
+
+  c8 chunk[4096];
+  u64 drained[2] = SL_ZERO;
+  while (drained[0] < 1000000 || drained[1] < 1000000) {
+    struct pollfd pfds[2] = {
+      { .fd = socks[0][0], .events = POLLIN },
+      { .fd = socks[1][0], .events = POLLIN },
+    };
+    ASSERT_GT(poll(pfds, 2, 5000), 0);
+    sl_for(it, 2) {
+      if (!pfds[it].revents) continue;
+      ssize_t n = read(socks[it][0], chunk, sizeof(chunk));
+      ASSERT_GT(n, 0);
+      drained[it] += (u64)n;
+    }
+    usleep(100);
+  }
+  EXPECT_EQ(sb_wait(flood), 0);
+  EXPECT_EQ(sb_forward_wait(flood, SL_STDOUT, &out), SL_OK);
+  EXPECT_EQ(out.bytes, 1000000u);
+  EXPECT_EQ(out.copy_len, 1000000u);
+  sl_free(out.copy);
+  EXPECT_EQ(sb_forward_wait(flood, SL_STDERR, &err), SL_OK);
+  EXPECT_EQ(err.bytes, 1000000u);
+  sl_for(it, 2) { sl_pipe_try_close(socks[it]); }
+  sb_destroy(flood);
+
+  /* a forwarder still running when the sandbox goes away is stopped */
+  sl_ctx_t* sleeper = sb_create(&opts);
+  ASSERT_TRUE(sleeper != SL_NULLPTR);
+  const c8* sleep_args[] = { "sleep", "--ms", "10000" };
+  ASSERT_EQ(sb_spawn(sleeper, cmd_cstr.data, sleep_args, SP_CARR_LEN(sleep_args), SL_NULLPTR), SL_OK);
+  ASSERT_EQ(sb_forward(sleeper, SL_STDOUT, file, 0), SL_OK);
+  sb_destroy(sleeper);
+
+  close(sink[0]);
+  close(file);
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, capture) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = {
+    "emit",
+    "--stdout",
+    "0123456789",
+    "--repeat",
+    "1000",
+  };
+
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+
+  /* 10000 bytes in, 4 + 6 kept */
+  sl_capture_opts_t capture = { .head = 4, .tail = 6 };
+  ASSERT_EQ(sb_capture(sb, SL_STDOUT, &capture), SL_OK);
+  EXPECT_EQ(sb_stdout_fd(sb), -1);
+  EXPECT_EQ(sb_wait(sb), 0);
+
+  sl_capture_t out = SL_ZERO;
+  ASSERT_EQ(sb_capture_wait(sb, SL_STDOUT, &out), SL_OK);
+  EXPECT_EQ(out.total, 10000u);
+  EXPECT_FALSE(out.over_quota);
+  ASSERT_EQ(out.head_len, 4u);
+  ASSERT_EQ(out.tail_len, 6u);
+  EXPECT_EQ(memcmp(out.head, "0123", 4), 0);
+  EXPECT_EQ(memcmp(out.tail, "456789", 6), 0);
+  sl_free(out.head);
+  sl_free(out.tail);
+  sb_destroy(sb);
+
+  /* a child that never stops is killed at the quota */
+  const c8* flood_args[] = { "emit", "--stdout", "0123456789", "--forever" };
+  sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, flood_args, SP_CARR_LEN(flood_args), SL_NULLPTR), SL_OK);
+  capture = (sl_capture_opts_t){ .head = 16, .tail = 16, .quota = 1024 * 1024 };
+  ASSERT_EQ(sb_capture(sb, SL_STDOUT, &capture), SL_OK);
+  EXPECT_EQ(sb_wait(sb), 128 + SIGKILL);
+
+  ASSERT_EQ(sb_capture_wait(sb, SL_STDOUT, &out), SL_OK);
+  EXPECT_TRUE(out.over_quota);
+  EXPECT_GT(out.total, (u64)1024 * 1024);
+  EXPECT_EQ(out.head_len, 16u);
+  EXPECT_EQ(out.tail_len, 16u);
+  sl_free(out.head);
+  sl_free(out.tail);
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, stdin_write) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* cat_args[] = { "cat" };
+
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, cat_args, SP_CARR_LEN(cat_args), SL_NULLPTR), SL_OK);
+
+  sl_capture_opts_t capture = { .head = 4, .tail = 4 };
+  ASSERT_EQ(sb_capture(sb, SL_STDOUT, &capture), SL_OK);
+
+  /* 32 MiB of gifted pages, then a copied tail, then EOF */
+  u64 len = 32 * 1024 * 1024;
+  u8* pages = (u8*)mmap(SL_NULLPTR, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_TRUE(pages != MAP_FAILED);
+  sl_for(it, (u32)len) { pages[it] = (u8)('a' + it % 26); }
+  EXPECT_EQ(sb_write_stdin(sb, pages, len, SL_WRITE_GIFT), (s64)len);
+  munmap(pages, len);
+  EXPECT_EQ(sb_write_stdin(sb, "tail", 4, 0), 4);
+  EXPECT_EQ(sb_close_stdin(sb), SL_OK);
+  EXPECT_EQ(sb_stdin_fd(sb), -1);
+  EXPECT_EQ(sb_wait(sb), 0);
+
+  sl_capture_t out = SL_ZERO;
+  ASSERT_EQ(sb_capture_wait(sb, SL_STDOUT, &out), SL_OK);
+  EXPECT_EQ(out.total, len + 4);
+  ASSERT_EQ(out.head_len, 4u);
+  ASSERT_EQ(out.tail_len, 4u);
+  EXPECT_EQ(memcmp(out.head, "abcd", 4), 0);
+  EXPECT_EQ(memcmp(out.tail, "tail", 4), 0);
+  sl_free(out.head);
+  sl_free(out.tail);
+  EXPECT_EQ(sb_close_stdin(sb), SL_ERROR_INVALID_STDIO);
+  sb_destroy(sb);
+
+  /* a child that never reads: an error, not a SIGPIPE */
+  const c8* exit_args[] = { "status", "--code", "0" };
+  sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, exit_args, SP_CARR_LEN(exit_args), SL_NULLPTR), SL_OK);
+  EXPECT_EQ(sb_wait(sb), 0);
+
+  c8 chunk[4096] = SL_ZERO;
+  EXPECT_EQ(sb_write_stdin(sb, chunk, sizeof(chunk), 0), -1);
+  EXPECT_TRUE(strstr(sb_error(sb), "stdin") != SL_NULLPTR);
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, pipe_options) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = {
+    "emit",
+    "--stdout",
+    "0123456789",
+    "--repeat",
+    "100000",
+  };
+
+  /* by default: close-on-exec, blocking */
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+  s32 fds[] = { sb_stdin_fd(sb), sb_stdout_fd(sb), sb_stderr_fd(sb) };
+  sl_for(it, SP_CARR_LEN(fds)) {
+    EXPECT_TRUE(fcntl(fds[it], F_GETFD) & FD_CLOEXEC);
+    EXPECT_FALSE(fcntl(fds[it], F_GETFL) & O_NONBLOCK);
+  }
+  sb_kill(sb, SIGKILL);
+  sb_wait(sb);
+  sb_destroy(sb);
+
+  opts.pipe_size = 1024 * 1024;
+  opts.pipe_flags = SL_PIPE_NONBLOCK;
+  sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+  s32 out = sb_stdout_fd(sb);
+  EXPECT_TRUE(fcntl(sb_stdin_fd(sb), F_GETFL) & O_NONBLOCK);
+  EXPECT_TRUE(fcntl(out, F_GETFL) & O_NONBLOCK);
+  EXPECT_TRUE(fcntl(out, F_GETFD) & FD_CLOEXEC);
+#if defined(SL_LINUX)
+  /* pipe-max-size is 1 MiB by default; a lowered one still beats 64 KiB */
+  EXPECT_GT(fcntl(out, F_GETPIPE_SZ), 64 * 1024);
+#endif
+
+  /* the parent's end never blocks; the child's still does, so nothing is lost */
+  u64 total = 0;
+  c8 buf[65536];
+  for (;;) {
+    ssize_t n = read(out, buf, sizeof(buf));
+    if (n == 0) break;
+    if (n > 0) {
+      total += (u64)n;
+      continue;
+    }
+    ASSERT_EQ(errno, EAGAIN);
+    struct pollfd pfd = { .fd = out, .events = POLLIN };
+    poll(&pfd, 1, -1);
+  }
+  EXPECT_EQ(total, 1000000u);
+  EXPECT_EQ(sb_wait(sb), 0);
+  sb_destroy(sb);
+
+  /* forwarding a non-blocking stream into a slowly drained blocking pipe */
+  s32 sink[2] = SL_NULL_PIPE;
+  ASSERT_EQ(pipe(sink), 0);
+  sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+  ASSERT_EQ(sb_forward(sb, SL_STDOUT, sink[1], 0), SL_OK);
+  close(sink[1]);
+  for (total = 0; total < 1000000;) {
+    ssize_t n = read(sink[0], buf, 4096);
+    ASSERT_GT(n, 0);
+    total += (u64)n;
+    usleep(100);
+  }
+  EXPECT_EQ(sb_wait(sb), 0);
+  sl_forward_result_t forwarded = SL_ZERO;
+  EXPECT_EQ(sb_forward_wait(sb, SL_STDOUT, &forwarded), SL_OK);
+  EXPECT_EQ(forwarded.bytes, 1000000u);
+  close(sink[0]);
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, fd_hygiene) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = { "fds" };
+
+  /* neither is close-on-exec; only the one asked for gets through */
+  s32 leaked = open("/dev/null", O_RDONLY);
+  s32 passed = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  ASSERT_GE(leaked, 0);
+  ASSERT_GE(passed, 0);
+
+  sb_opts_t opts = SL_ZERO;
+  c8 expected[16] = SL_ZERO;
+  sl_for(inherit, 2) {
+    opts.inherit_fds = inherit ? &passed : SL_NULLPTR;
+    opts.num_inherit_fds = inherit;
+    snprintf(expected, sizeof(expected), inherit ? "%d" : "", passed);
+
+    sl_ctx_t* sb = sb_create(&opts);
+    ASSERT_TRUE(sb != SL_NULLPTR);
+    ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+
+    sl_capture_opts_t capture = { .head = 64 };
+    ASSERT_EQ(sb_capture(sb, SL_STDOUT, &capture), SL_OK);
+    EXPECT_EQ(sb_wait(sb), 0);
+
+    sl_capture_t out = SL_ZERO;
+    ASSERT_EQ(sb_capture_wait(sb, SL_STDOUT, &out), SL_OK);
+    EXPECT_EQ(out.head_len, (u64)strlen(expected));
+    EXPECT_EQ(memcmp(out.head, expected, out.head_len), 0);
+    sl_free(out.head);
+    sl_free(out.tail);
+    sb_destroy(sb);
+  }
+
+  /* the parent's descriptors are untouched */
+  EXPECT_FALSE(fcntl(leaked, F_GETFD) & FD_CLOEXEC);
+  EXPECT_TRUE(fcntl(passed, F_GETFD) & FD_CLOEXEC);
+
+  /* inheriting something that isn't open fails the spawn */
+  s32 closed = 1000;
+  ASSERT_LT(fcntl(closed, F_GETFD), 0);
+  opts.inherit_fds = &closed;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  EXPECT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_ERROR_PIPE);
+  ASSERT_TRUE(sb_error(sb) != SL_NULLPTR);
+  EXPECT_TRUE(strstr(sb_error(sb), "close fds") != SL_NULLPTR);
+  sb_destroy(sb);
+  close(passed);
+  close(leaked);
+}
+
+UTEST_F(stevelock, zygote) {
+  sb_runtime_opts_t runtime = { .zygote = true };
+#if !defined(SL_LINUX)
+  EXPECT_EQ(sb_runtime_init(&runtime), SL_ERROR_UNSUPPORTED_KERNEL);
+  return;
+#endif
+  ASSERT_EQ(sb_runtime_init(&runtime), SL_OK);
+  ASSERT_GT(sl_rt.zygote.pid, 0);
+  EXPECT_EQ(sb_runtime_init(&runtime), SL_OK);
+
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* fds_args[] = { "fds" };
+
+  /* an inherited fd keeps its number, whatever it arrived as in the zygote */
+  s32 passed = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  ASSERT_GE(passed, 0);
+  sb_opts_t opts = { .inherit_fds = &passed, .num_inherit_fds = 1 };
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, fds_args, SP_CARR_LEN(fds_args), SL_NULLPTR), SL_OK);
+  EXPECT_EQ(sb_pidfd(sb) >= 0, sl_capabilities()->pidfd);
+
+  sl_capture_opts_t capture = { .head = 64 };
+  ASSERT_EQ(sb_capture(sb, SL_STDOUT, &capture), SL_OK);
+  EXPECT_EQ(sb_wait(sb), 0);
+  sl_capture_t out = SL_ZERO;
+  ASSERT_EQ(sb_capture_wait(sb, SL_STDOUT, &out), SL_OK);
+  c8 expected[16] = SL_ZERO;
+  snprintf(expected, sizeof(expected), "%d", passed);
+  EXPECT_EQ(out.head_len, (u64)strlen(expected));
+  EXPECT_EQ(memcmp(out.head, expected, out.head_len), 0);
+  sl_free(out.head);
+  sl_free(out.tail);
+  sb_destroy(sb);
+  close(passed);
+
+  /* more than a zygote request carries is refused up front */
+  s32 many[65];
+  sl_for(it, 65) { many[it] = (s32)it; }
+  opts = (sb_opts_t){ .inherit_fds = many, .num_inherit_fds = 65 };
+  EXPECT_TRUE(sb_create(&opts) == SL_NULLPTR);
+
+  /* the children are ours: exec failures, exit codes and kill all behave */
+  opts = (sb_opts_t)SL_ZERO;
+  sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  EXPECT_EQ(sb_spawn(sb, "/nonexistent/stevelock-command", SL_NULLPTR, 0, SL_NULLPTR), SL_ERROR_EXEC);
+
+  const c8* status_args[] = { "status", "--code", "7" };
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, status_args, SP_CARR_LEN(status_args), SL_NULLPTR), SL_OK);
+  EXPECT_EQ(sb_wait(sb), 7);
+
+  const c8* sleep_args[] = { "sleep", "--ms", "0" };
+  sl_child_t* child = SL_NULLPTR;
+  ASSERT_EQ(sb_spawn_child(sb, cmd_cstr.data, sleep_args, SP_CARR_LEN(sleep_args), SL_NULLPTR, &child), SL_OK);
+  EXPECT_EQ(sb_child_kill(child, SIGKILL), 0);
+  EXPECT_EQ(sb_child_wait(child), 128 + SIGKILL);
+  sb_child_destroy(child);
+
+  /* back to spawning directly */
+  sb_runtime_shutdown();
+  EXPECT_EQ(sl_rt.zygote.fd, -1);
+  ASSERT_EQ(sb_spawn_child(sb, cmd_cstr.data, status_args, SP_CARR_LEN(status_args), SL_NULLPTR, &child), SL_OK);
+  EXPECT_EQ(sb_child_wait(child), 7);
+  sb_child_destroy(child);
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, fork_server) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+
+  sl_server_t* server = sb_server_create(sb);
+#if !defined(SL_LINUX)
+  EXPECT_TRUE(server == SL_NULLPTR);
+  sb_destroy(sb);
+  return;
+#endif
+  ASSERT_TRUE(server != SL_NULLPTR);
+
+  /* the children run under the server's domain: no writes outside the scope */
+  c8 path[64];
+  snprintf(path, sizeof(path), "/tmp/stevelock-server-%d", (s32)getpid());
+  unlink(path);
+  const c8* write_args[] = { "write-file", "--path", path };
+  sl_child_t* child = SL_NULLPTR;
+  ASSERT_EQ(sb_server_spawn(server, cmd_cstr.data, write_args, SP_CARR_LEN(write_args), SL_NULLPTR, &child), SL_OK);
+  EXPECT_NE(sb_child_wait(child), 0);
+  EXPECT_NE(access(path, F_OK), 0);
+  sb_child_destroy(child);
+
+  /* many short tasks, each with its own stdio */
+  const c8* emit_args[] = { "emit", "--stdout", "task" };
+  sl_for(it, 32) {
+    ASSERT_EQ(sb_server_spawn(server, cmd_cstr.data, emit_args, SP_CARR_LEN(emit_args), SL_NULLPTR, &child), SL_OK);
+    c8 buf[8] = SL_ZERO;
+    EXPECT_EQ(read(sb_child_stdout_fd(child), buf, sizeof(buf)), 4);
+    EXPECT_EQ(memcmp(buf, "task", 4), 0);
+    EXPECT_EQ(sb_child_wait(child), 0);
+    sb_child_destroy(child);
+  }
+
+  EXPECT_EQ(sb_server_spawn(server, "/nonexistent/stevelock-command", SL_NULLPTR, 0, SL_NULLPTR, &child), SL_ERROR_EXEC);
+  EXPECT_TRUE(child == SL_NULLPTR);
+
+  /* children outlive the server */
+  const c8* status_args[] = { "status", "--code", "9" };
+  ASSERT_EQ(sb_server_spawn(server, cmd_cstr.data, status_args, SP_CARR_LEN(status_args), SL_NULLPTR, &child), SL_OK);
+  sb_server_destroy(server);
+  EXPECT_EQ(sb_child_wait(child), 9);
+  sb_child_destroy(child);
+  sb_destroy(sb);
+}
+
+typedef struct {
+  const c8* path;
+  s32 touched;
+} sl_test_fn_arg_t;
+
+/* Writes to stdout both ways, then tries to escape the write scope. */
+static s32 sl_test_fn(void* userdata) {
+  sl_test_fn_arg_t* arg = (sl_test_fn_arg_t*)userdata;
+  arg->touched = 1;
+  printf("printf ");
+  fflush(stdout);
+  ssize_t n = write(STDOUT_FILENO, "write", 5);
+  (void)n;
+
+  s32 fd = open(arg->path, O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+  if (fd >= 0) {
+    close(fd);
+    return 1;
+  }
+  return errno == EACCES || errno == EPERM ? 42 : 2;
+}
+
+UTEST_F(stevelock, spawn_fn) {
+  c8 path[64];
+  snprintf(path, sizeof(path), "/tmp/stevelock-fn-%d", (s32)getpid());
+  unlink(path);
+
+  sb_opts_t opts = SL_ZERO;
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+
+  /* the callback runs under the policy, on a copy of our memory */
+  sl_test_fn_arg_t arg = { .path = path };
+  ASSERT_EQ(sb_spawn_fn(sb, sl_test_fn, &arg), SL_OK);
+  EXPECT_GT(sb_pid(sb), 0);
+  if (sl_capabilities()->pidfd) EXPECT_GE(sb_pidfd(sb), 0);
+  c8 buffer[64];
+  sp_str_t out = sl_test_read_fd(sb_stdout_fd(sb), buffer, sizeof(buffer));
+  EXPECT_TRUE(sp_str_equal(out, SP_LIT("printf write")));
+  EXPECT_EQ(sb_wait(sb), 42);
+  EXPECT_NE(access(path, F_OK), 0);
+  EXPECT_EQ(arg.touched, 0);
+  EXPECT_EQ(sb_stats(sb)->num_spawns, 1u);
+
+  /* one-shot, like sb_spawn */
+  EXPECT_EQ(sb_spawn_fn(sb, sl_test_fn, &arg), SL_ERROR);
+  EXPECT_EQ(sb_spawn_fn(sb, SL_NULLPTR, &arg), SL_ERROR_INVALID_COMMAND);
+  EXPECT_EQ(sb_spawn_fn(SL_NULLPTR, sl_test_fn, &arg), SL_ERROR_INVALID_CONTEXT);
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, memfd_output) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = {
+    "emit",
+    "--stdout",
+    "0123456789",
+    "--repeat",
+    "100000",
+  };
+
+  sb_opts_t opts = {
+    .stdio = {
+      .out = { .mode = SL_STDIO_MEMFD },
+      .err = { .mode = SL_STDIO_MEMFD },
+    },
+  };
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_OK);
+
+  /* far more than a pipe holds, with nobody reading */
+  EXPECT_EQ(sb_wait(sb), 0);
+
+  sl_output_t out = SL_ZERO;
+  ASSERT_EQ(sb_output_map(sb, SL_STDOUT, &out), SL_OK);
+  ASSERT_EQ(out.len, 1000000u);
+  EXPECT_EQ(memcmp(out.data, "0123456789", 10), 0);
+  EXPECT_EQ(memcmp(out.data + out.len - 10, "0123456789", 10), 0);
+
+  sl_output_t err = SL_ZERO;
+  ASSERT_EQ(sb_output_map(sb, SL_STDERR, &err), SL_OK);
+  EXPECT_TRUE(err.data == SL_NULLPTR);
+  EXPECT_EQ(err.len, 0u);
+
+  /* the mapping outlives the sandbox */
+  sb_destroy(sb);
+  EXPECT_EQ(out.data[5], '5');
+  sb_output_unmap(&out);
+  EXPECT_TRUE(out.data == SL_NULLPTR);
+
+  /* only memfd streams of exited children map */
+  sb_opts_t piped = SL_ZERO;
+  sb = sb_create(&piped);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, args, 3, SL_NULLPTR), SL_OK);
+  EXPECT_EQ(sb_output_map(sb, SL_STDOUT, &out), SL_ERROR_INVALID_STDIO);
+  EXPECT_EQ(sb_wait(sb), 0);
+  sb_destroy(sb);
+
+  const c8* sleep_args[] = { "sleep", "--ms", "10000" };
+  sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, sleep_args, SP_CARR_LEN(sleep_args), SL_NULLPTR), SL_OK);
+  EXPECT_EQ(sb_output_map(sb, SL_STDOUT, &out), SL_ERROR);
+  sb_destroy(sb);
+
+  opts.stdio.in = (sl_stdio_stream_t){ .mode = SL_STDIO_MEMFD };
+  sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  EXPECT_EQ(sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR), SL_ERROR_INVALID_STDIO);
+  sb_destroy(sb);
+
+  /* a grandchild still holding the file can't shrink it under the mapping */
+  const c8* truncate_args[] = { "truncate-later", "--size", "100000", "--ms", "100" };
+  opts.stdio.in = (sl_stdio_stream_t)SL_ZERO;
+  sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+  ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, truncate_args, SP_CARR_LEN(truncate_args), SL_NULLPTR), SL_OK);
+  EXPECT_EQ(sb_wait(sb), 0);
+  ASSERT_EQ(sb_output_map(sb, SL_STDOUT, &out), SL_OK);
+  ASSERT_EQ(out.len, 100000u);
+  usleep(300 * 1000);
+  EXPECT_EQ(out.data[out.len - 1], 'x');
+  sb_output_unmap(&out);
+  sb_destroy(sb);
+}
+
+UTEST_F(stevelock, loop) {
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = {
+    "emit",
+    "--stdout",
+    "0123456789",
+    "--repeat",
+    "100000",
+    "--stderr",
+    "e",
+  };
+
+  /* the same traffic through epoll, then io_uring where the kernel has it */
+  sl_loop_backend_t backends[] = { SL_LOOP_BACKEND_POLL, SL_LOOP_BACKEND_IO_URING };
+  sl_for(pass, SP_CARR_LEN(backends)) {
+    enum { NUM_CHILDREN = 8 };
+    sb_opts_t opts = SL_ZERO;
+    sl_ctx_t* sb = sb_create(&opts);
+    ASSERT_TRUE(sb != SL_NULLPTR);
+
+    sb_loop_opts_t loop_opts = { .backend = backends[pass] };
+    sl_loop_t* loop = sb_loop_create(&loop_opts);
+    if (backends[pass] == SL_LOOP_BACKEND_IO_URING && !sl_capabilities()->io_uring) {
+      EXPECT_TRUE(loop == SL_NULLPTR);
+      sb_destroy(sb);
+      continue;
+    }
+    ASSERT_TRUE(loop != SL_NULLPTR);
+    EXPECT_EQ(sb_loop_backend(loop), backends[pass]);
+    EXPECT_GE(sb_loop_fd(loop), 0);
+
+    sl_child_t* children[NUM_CHILDREN] = SL_ZERO;
+    u64 out[NUM_CHILDREN] = SL_ZERO;
+    u64 err[NUM_CHILDREN] = SL_ZERO;
+    s32 codes[NUM_CHILDREN];
+    u32 eofs = 0;
+    u32 exits = 0;
+    sl_for(it, NUM_CHILDREN) {
+      codes[it] = -1;
+      ASSERT_EQ(sb_spawn_child(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR, &children[it]), SL_OK);
+      ASSERT_EQ(sb_loop_add_child(loop, children[it], (void*)(uintptr_t)it), SL_OK);
+    }
+    EXPECT_EQ(sb_loop_add_child(loop, children[0], SL_NULLPTR), SL_ERROR);
+
+    /* everything arrives through the one loop, then each child leaves it */
+    sl_loop_event_t events[32];
+    while (eofs < 2 * NUM_CHILDREN || exits < NUM_CHILDREN) {
+      s32 n = sb_loop_poll(loop, events, SP_CARR_LEN(events), 5000);
+      ASSERT_GT(n, 0);
+
+      sl_for(it, (u32)n) {
+        u32 index = (u32)(uintptr_t)events[it].user;
+        ASSERT_LT(index, (u32)NUM_CHILDREN);
+        EXPECT_TRUE(events[it].child == children[index]);
+
+        if (events[it].last) EXPECT_TRUE(children[index]->loop == SL_NULLPTR);
+        if (events[it].kind == SL_LOOP_EXIT) {
+          codes[index] = events[it].exit_code;
+          exits++;
+          continue;
+        }
+        if (!events[it].len) eofs++;
+        if (events[it].kind == SL_LOOP_STDOUT) out[index] += events[it].len;
+        if (events[it].kind == SL_LOOP_STDERR) err[index] += events[it].len;
+      }
+    }
+
+    sl_for(it, NUM_CHILDREN) {
+      EXPECT_EQ(out[it], 1000000u);
+      EXPECT_EQ(err[it], 100000u);
+      EXPECT_EQ(codes[it], 0);
+      EXPECT_TRUE(children[it]->loop == SL_NULLPTR);
+      sb_child_destroy(children[it]);
+    }
+    EXPECT_EQ(sb_loop_poll(loop, events, SP_CARR_LEN(events), 0), 0);
+
+    /* releasing a child takes it out of the loop */
+    const c8* sleep_args[] = { "sleep", "--ms", "10000" };
+    ASSERT_EQ(sb_spawn(sb, cmd_cstr.data, sleep_args, SP_CARR_LEN(sleep_args), SL_NULLPTR), SL_OK);
+    ASSERT_EQ(sb_loop_add(loop, sb, SL_NULLPTR), SL_OK);
+    EXPECT_EQ(sb_loop_poll(loop, events, SP_CARR_LEN(events), 0), 0);
+    sb_destroy(sb);
+    EXPECT_EQ(sb_loop_poll(loop, events, SP_CARR_LEN(events), 0), 0);
+
+    sb_loop_destroy(loop);
+  }
+}
+
+UTEST_F(stevelock, capabilities) {
+  const sl_caps_t* caps = sl_capabilities();
+  ASSERT_TRUE(caps != SL_NULLPTR);
+  EXPECT_TRUE(caps == sl_capabilities());
+  EXPECT_TRUE(caps->available);
+
+#if defined(SL_LINUX)
+  EXPECT_GE(caps->abi, 1);
+  EXPECT_NE(caps->fs, 0);
+  EXPECT_EQ(caps->ioctl_dev, caps->abi >= 5);
+  EXPECT_EQ(caps->scoped, caps->abi >= 6);
+#endif
+}
+
 UTEST_F(stevelock, descriptor_semantics) {
   sp_str_t cmd = sl_test_testbox_path();
   sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
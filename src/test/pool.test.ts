@@ -0,0 +1,20 @@
+import { expect, test } from "bun:test";
+import fs from "fs";
+import os from "os";
+import path from "path";
+import { pool } from "../index.ts";
+
+test("pool: a reply bigger than the pipe arrives whole", async () => {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), "stevelock-pool-"));
+  const script = path.join(dir, "repeat.mjs");
+  fs.writeFileSync(script, "export default (n) => 'x'.repeat(n);\n");
+
+  const workers = pool({ size: 1 });
+  try {
+    expect(await workers.run<string>(script, 1 << 20)).toHaveLength(1 << 20);
+    expect(await workers.run<string>(script, 3)).toBe("xxx");
+  } finally {
+    workers.destroy();
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+});
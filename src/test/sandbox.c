@@ -660,6 +660,46 @@ UTEST_F(stevelock, sandbox_spawn_nonexistent_read_dir) {
   sb_destroy(sb);
 }
 
+UTEST_F(stevelock, sandbox_spawn_file_write_dir) {
+  c8 root_template[256] = SL_ZERO;
+  sp_str_t root = sl_test_make_case_root(utest_result, "file-write-dir", root_template, SP_CARR_LEN(root_template));
+  ASSERT_FALSE(sp_str_empty(root));
+
+  sp_str_t file = sp_str_null_terminate(sp_fs_join_path(root, SP_LIT("not-a-dir")));
+  sp_io_writer_t writer = sp_io_writer_from_file(file, SP_IO_WRITE_MODE_OVERWRITE);
+  sp_io_write_cstr(&writer, "x");
+  sp_io_writer_close(&writer);
+
+  const c8* write_dirs[] = {
+    file.data,
+  };
+
+  sb_opts_t opts = {
+    .write = {
+      .dirs = (c8**)write_dirs,
+      .num_dirs = SP_CARR_LEN(write_dirs),
+    },
+  };
+
+  sl_ctx_t* sb = sb_create(&opts);
+  ASSERT_TRUE(sb != SL_NULLPTR);
+
+  sp_str_t cmd = sl_test_testbox_path();
+  sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
+  const c8* args[] = {
+    "status",
+    "--code",
+    "0",
+  };
+
+  sl_err_t err = sb_spawn(sb, cmd_cstr.data, args, SP_CARR_LEN(args), SL_NULLPTR);
+  EXPECT_EQ(err, SL_ERROR_INVALID_SCOPE);
+  EXPECT_TRUE(sb_error(sb) != SL_NULLPTR);
+  sb_destroy(sb);
+
+  sp_fs_remove_dir(root);
+}
+
 UTEST_F(stevelock, sandbox_network_denied_connect) {
   sp_str_t cmd = sl_test_net_probe_path();
   sp_str_t cmd_cstr = sp_str_null_terminate(cmd);
@@ -199,6 +199,14 @@ const native = {
 
 const testAddon = (target: Platform.Target) => {
   buildAddon(target);
+
+  const result = Bun.spawnSync(["bun", "test", "./src/test"], {
+    cwd: root,
+    stdio: ["inherit", "inherit", "inherit"],
+  });
+  if (!result.success) {
+    throw new Error(`bun test exited with code ${result.exitCode}`);
+  }
 };
 
 const packageAddon = async (target: Platform.Target, value?: string) => {
@@ -290,7 +298,7 @@ const main = async () => {
     .command("test:native", "configure, build, and run native tests", {
       asan: { type: "boolean", default: false },
     })
-    .command("test:addon", "build host addon")
+    .command("test:addon", "build host addon and run the JS tests")
     .command("package:addon", "package host addon tarball", {
       version: { type: "string" },
     })